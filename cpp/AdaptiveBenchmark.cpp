@@ -0,0 +1,156 @@
+/* 
+ * Benchmark of the adaptive Huffman coders
+ * 
+ * Usage: AdaptiveBenchmark [InputFile]
+ * Compresses and decompresses the given file in memory (or, if no file is given, generated text
+ * with a skewed symbol distribution) with several settings of "AdaptiveHuffmanCompress": rebuilding
+ * the code tree from the frequency table on each schedule and with each aging method, rebuilding it
+ * on a helper thread while coding continues with the previous code, and dynamic Huffman coding that
+ * updates the code after every symbol. The compressed size of each scheme and the best time of each
+ * direction are reported, as throughput of uncompressed bytes.
+ * The default build flags enable a sanitizer, so for meaningful numbers build with
+ * optimization only, for example: make CXXFLAGS="-std=c++11 -O2" AdaptiveBenchmark
+ * 
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "AdaptiveModel.hpp"
+#include "BitIoStream.hpp"
+
+using std::uint8_t;
+using std::uint32_t;
+using std::vector;
+
+
+static const int NUM_TRIALS = 5;
+
+static vector<uint8_t> generateSkewedData(std::size_t length);
+static void compress(const AdaptiveSettings &settings, const vector<uint8_t> &data, vector<uint8_t> &out);
+static void decompress(const vector<uint8_t> &data, vector<uint8_t> &out);
+static double timeBest(const AdaptiveSettings &settings, const vector<uint8_t> &input, vector<uint8_t> &output, bool decode);
+
+
+int main(int argc, char *argv[]) {
+	// Handle command line arguments
+	if (argc > 2) {
+		std::cerr << "Usage: " << argv[0] << " [InputFile]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	vector<uint8_t> data;
+	if (argc == 2) {
+		std::ifstream in(argv[1], std::ios::binary);
+		if (!in) {
+			std::cerr << "Cannot open " << argv[1] << std::endl;
+			return EXIT_FAILURE;
+		}
+		data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	} else
+		data = generateSkewedData(UINT32_C(1) << 22);
+	std::cout << "Input: " << data.size() << " bytes" << std::endl;
+	
+	// The schemes to compare, named like the options of AdaptiveHuffmanCompress
+	vector<std::pair<const char *, AdaptiveSettings> > schemes;
+	AdaptiveSettings settings;
+	schemes.emplace_back("Default", settings);
+	settings.schedule = AdaptiveSettings::SCHEDULE_FIXED;
+	settings.interval = 4096;
+	schemes.emplace_back("Fixed 4096", settings);
+	settings.mode = AdaptiveSettings::MODE_PIPELINED;
+	schemes.emplace_back("Fixed 4096, pipelined", settings);
+	settings = AdaptiveSettings();
+	settings.aging = AdaptiveSettings::AGING_HALVE;
+	schemes.emplace_back("Halve", settings);
+	settings.aging = AdaptiveSettings::AGING_WINDOW;
+	schemes.emplace_back("Window", settings);
+	settings = AdaptiveSettings();
+	settings.mode = AdaptiveSettings::MODE_DYNAMIC;
+	schemes.emplace_back("Dynamic", settings);
+	
+	// Time each scheme in both directions
+	double megabytes = data.size() / 1.0e6;
+	vector<uint8_t> compressed;
+	vector<uint8_t> decompressed;
+	for (const auto &scheme : schemes) {
+		double compTime = timeBest(scheme.second, data, compressed, false);
+		double decompTime = timeBest(scheme.second, compressed, decompressed, true);
+		if (decompressed != data)
+			throw std::logic_error("Assertion error: Decoded data mismatch");
+		std::cout << scheme.first << ": " << compressed.size() << " bytes, compress " << megabytes / compTime
+			<< " MB/s, decompress " << megabytes / decompTime << " MB/s" << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
+
+
+// Returns text-like data where a few symbols are very common and most are rare (Zipf distribution).
+static vector<uint8_t> generateSkewedData(std::size_t length) {
+	vector<double> weights;
+	for (int i = 0; i < 64; i++)
+		weights.push_back(1.0 / (i + 1));
+	std::mt19937 rng(1);
+	std::discrete_distribution<int> dist(weights.begin(), weights.end());
+	vector<uint8_t> result;
+	for (std::size_t i = 0; i < length; i++)
+		result.push_back(static_cast<uint8_t>(' ' + dist(rng)));
+	return result;
+}
+
+
+// Compresses like AdaptiveHuffmanCompress with the options of the given settings.
+static void compress(const AdaptiveSettings &settings, const vector<uint8_t> &data, vector<uint8_t> &out) {
+	BitOutputStream bout(out);
+	settings.writeHeader(bout);
+	AdaptiveModel model(settings);
+	for (uint8_t b : data) {
+		model.write(bout, b);
+		model.update(b);
+	}
+	model.write(bout, 256);  // EOF
+	bout.finish();
+}
+
+
+// Decompresses like AdaptiveHuffmanDecompress.
+static void decompress(const vector<uint8_t> &data, vector<uint8_t> &out) {
+	BitInputStream bin(data.data(), data.size());
+	AdaptiveModel model(AdaptiveSettings::readHeader(bin));
+	while (true) {
+		uint32_t symbol = model.read(bin);
+		if (symbol == 256)  // EOF symbol
+			break;
+		out.push_back(static_cast<uint8_t>(symbol));
+		model.update(symbol);
+	}
+}
+
+
+// Compresses (or decompresses, if decode is true) the given input several times and returns the best
+// time in seconds. The output of the last run is left in the given vector.
+static double timeBest(const AdaptiveSettings &settings, const vector<uint8_t> &input, vector<uint8_t> &output, bool decode) {
+	double bestTime = 1.0e30;
+	for (int trial = 0; trial < NUM_TRIALS; trial++) {
+		output.clear();
+		auto start = std::chrono::steady_clock::now();
+		if (decode)
+			decompress(input, output);
+		else
+			compress(settings, input, output);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		bestTime = std::min(elapsed.count(), bestTime);
+	}
+	return bestTime;
+}
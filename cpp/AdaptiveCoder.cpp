@@ -0,0 +1,123 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include "AdaptiveCoder.hpp"
+#include "CodeTree.hpp"
+
+using std::uint32_t;
+using std::uint64_t;
+
+
+AdaptiveCoder::AdaptiveCoder(uint32_t symbolLimit) :
+		codes(symbolLimit, 0),
+		leafParents(symbolLimit, UINT32_MAX),
+		table(static_cast<std::size_t>(1) << TABLE_BITS, 0) {
+	if (symbolLimit < 2)
+		throw std::domain_error("At least 2 symbols needed");
+	if (symbolLimit > (UINT32_C(1) << 24))
+		throw std::domain_error("Too many symbols");
+	nodes.reserve((symbolLimit - 1) * 2);
+	nodeCodes.resize(symbolLimit - 1);
+	nodeParents.resize(symbolLimit - 1);
+}
+
+
+void AdaptiveCoder::rebuild(const FrequencyTable &freqs) {
+	if (freqs.getSymbolLimit() != codes.size())
+		throw std::domain_error("Symbol limit mismatch");
+	freqs.buildChildEntries(nodes, workspace);
+	std::fill(codes.begin(), codes.end(), 0);
+	std::fill(leafParents.begin(), leafParents.end(), UINT32_MAX);
+	
+	// Parents have higher indexes than their children, so a single pass
+	// downward from the root reaches every node after its parent
+	uint32_t root = static_cast<uint32_t>(nodes.size() / 2 - 1);
+	for (uint32_t i = root + 1; i-- > 0; ) {
+		uint64_t code = i == root ? 0 : nodeCodes[i];
+		uint32_t length = static_cast<uint32_t>(code & 0xFF);
+		for (uint32_t bit = 0; bit < 2; bit++) {
+			uint32_t entry = nodes[i * 2 + bit];
+			uint64_t childCode = 0;  // The path is too long for the table
+			if ((code != 0 || i == root) && length < MAX_TABLE_CODE_LENGTH)
+				childCode = ((code >> 8 << 1 | bit) << 8) | (length + 1);
+			if (CodeTree::isLeaf(entry)) {
+				uint32_t symbol = CodeTree::getSymbol(entry);
+				codes[symbol] = childCode;
+				leafParents[symbol] = i << 1 | bit;
+			} else {
+				nodeCodes[entry] = childCode;
+				nodeParents[entry] = i << 1 | bit;
+			}
+		}
+	}
+	fillTable(root, 0, 0);
+}
+
+
+void AdaptiveCoder::write(BitOutputStream &out, uint32_t symbol) const {
+	if (symbol >= codes.size())
+		throw std::domain_error("Symbol out of range");
+	uint64_t code = codes[symbol];
+	if (code != 0)
+		out.writeBits(code >> 8, static_cast<int>(code & 0xFF));
+	else
+		writeLongCode(out, symbol);
+}
+
+
+uint32_t AdaptiveCoder::read(BitInputStream &in) const {
+	uint32_t entry = table[in.peekBits(TABLE_BITS)];
+	int length = static_cast<int>(entry & 0xFF);
+	if (length != 0) {
+		in.consumeBits(length);
+		return entry >> 8;
+	}
+	in.consumeBits(TABLE_BITS);
+	for (uint32_t node = entry >> 8; ; ) {
+		entry = nodes[node * 2 + static_cast<uint32_t>(in.readNoEof())];
+		if (CodeTree::isLeaf(entry))
+			return CodeTree::getSymbol(entry);
+		node = entry;
+	}
+}
+
+
+void AdaptiveCoder::writeLongCode(BitOutputStream &out, uint32_t symbol) const {
+	if (leafParents[symbol] == UINT32_MAX)
+		throw std::domain_error("No code for given symbol");
+	// Collect the bits from the leaf up to the root, then write them in reverse
+	uint32_t root = static_cast<uint32_t>(nodes.size() / 2 - 1);
+	std::vector<char> bits;
+	for (uint32_t link = leafParents[symbol]; ; link = nodeParents[link >> 1]) {
+		bits.push_back(static_cast<char>(link & 1));
+		if (link >> 1 == root)
+			break;
+	}
+	for (auto it = bits.crbegin(); it != bits.crend(); ++it)
+		out.writeBits(static_cast<uint64_t>(*it), 1);
+}
+
+
+void AdaptiveCoder::fillTable(uint32_t node, uint32_t path, int depth) {
+	for (uint32_t bit = 0; bit < 2; bit++) {
+		uint32_t entry = nodes[node * 2 + bit];
+		uint32_t childPath = path << 1 | bit;
+		int childDepth = depth + 1;
+		if (CodeTree::isLeaf(entry)) {
+			// Every window that starts with this code decodes to this symbol
+			int shift = TABLE_BITS - childDepth;
+			std::fill_n(table.begin() + (childPath << shift), static_cast<std::size_t>(1) << shift,
+				CodeTree::getSymbol(entry) << 8 | static_cast<uint32_t>(childDepth));
+		} else if (childDepth == TABLE_BITS)
+			table[childPath] = entry << 8;
+		else
+			fillTable(entry, childPath, childDepth);
+	}
+}
@@ -0,0 +1,88 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "BitIoStream.hpp"
+#include "FrequencyTable.hpp"
+
+
+/* 
+ * Encodes and decodes symbols with the code tree that FrequencyTable::buildCodeTree() would return, for adaptive
+ * coding where the code is rebuilt from changing frequencies many times. Every array (the tree, the encoding
+ * table, the decoding table, and the temporary arrays of the tree building) is kept between rebuilds and
+ * overwritten in place, so after the first rebuild, a rebuild does not allocate memory. The codes are exactly
+ * those of the code tree (not a canonical code), so the output is the same as with HuffmanEncoder and CodeTree.
+ * Decoding looks up the next TABLE_BITS bits in a table, and only walks the tree for longer codes.
+ */
+class AdaptiveCoder final {
+	
+	/*---- Constants ----*/
+	
+	// The number of bits used to index the decoding table.
+	public: static const int TABLE_BITS = 10;
+	
+	// The longest code that is stored in the encoding table. Longer codes are found by walking up the tree.
+	private: static const std::uint32_t MAX_TABLE_CODE_LENGTH = 56;
+	
+	
+	/*---- Fields ----*/
+	
+	// The temporary arrays for building the tree.
+	private: FrequencyTable::Workspace workspace;
+	
+	// The child entries of the current code tree, in the layout of CodeTree.
+	private: std::vector<std::uint32_t> nodes;
+	
+	// For each symbol, (code << 8) | codeLength if it has a code of at most MAX_TABLE_CODE_LENGTH bits, otherwise 0.
+	private: std::vector<std::uint64_t> codes;
+	
+	// For each internal node other than the root, its path from the root in the same format as codes. Only used by rebuild().
+	private: std::vector<std::uint64_t> nodeCodes;
+	
+	// For each symbol, (parent << 1) | bit, where bit is 1 if the leaf is the right child of internal node parent,
+	// or UINT32_MAX if the symbol has no code. Likewise for each internal node except the root in nodeParents.
+	private: std::vector<std::uint32_t> leafParents;
+	private: std::vector<std::uint32_t> nodeParents;
+	
+	// For each window of TABLE_BITS bits, (symbol << 8) | codeLength if the window starts with a code of
+	// length at most TABLE_BITS, otherwise (node << 8) for the internal node reached after TABLE_BITS bits.
+	private: std::vector<std::uint32_t> table;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Constructs a coder for the given number of symbols (between 2 and 2^24), which has no code until rebuild() is called.
+	public: explicit AdaptiveCoder(std::uint32_t symbolLimit);
+	
+	
+	/*---- Methods ----*/
+	
+	// Replaces the code by the code tree of the given frequencies, whose symbol limit must equal this coder's.
+	public: void rebuild(const FrequencyTable &freqs);
+	
+	
+	// Writes the current code of the given symbol to the given stream.
+	public: void write(BitOutputStream &out, std::uint32_t symbol) const;
+	
+	
+	// Reads from the given stream to decode the next symbol with the current code.
+	public: std::uint32_t read(BitInputStream &in) const;
+	
+	
+	// Slow path of write(), for a code longer than MAX_TABLE_CODE_LENGTH or a symbol without a code.
+	private: void writeLongCode(BitOutputStream &out, std::uint32_t symbol) const;
+	
+	
+	// Fills the decoding table entries for the subtree of the given internal node, which is reached by the given
+	// path of the given number of bits (less than TABLE_BITS) from the root.
+	private: void fillTable(std::uint32_t node, std::uint32_t path, int depth);
+	
+};
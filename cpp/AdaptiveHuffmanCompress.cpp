@@ -1,13 +1,23 @@
 /* 
  * Compression application using adaptive Huffman coding
  * 
- * Usage: AdaptiveHuffmanCompress InputFile OutputFile
+ * Usage: AdaptiveHuffmanCompress [--dynamic | --lag=N] [--schedule=doubling|fixed] [--interval=N]
+ *            [--aging=reset|halve|window] [--period=N] InputFile OutputFile
  * Then use the corresponding "AdaptiveHuffmanDecompress" application to recreate the original input file.
  * Note that the application starts with a flat frequency table of 257 symbols (all set to a frequency of 1),
  * collects statistics while bytes are being encoded, and regenerates the Huffman code periodically. The
  * corresponding decompressor program also starts with a flat frequency table, updates it while bytes are being
  * decoded, and regenerates the Huffman code periodically at the exact same points in time. It is by design that
  * the compressor and decompressor have synchronized states, so that the data can be decompressed properly.
+ * The options choose when the code is regenerated and how old statistics are forgotten (see AdaptiveModel.hpp):
+ * --schedule=doubling (default) regenerates after 1, 2, 4, ... bytes and then every interval, --schedule=fixed only
+ * every interval. --aging=reset (default) resets the table every period, --aging=halve halves it instead,
+ * and --aging=window counts only the last period bytes. The interval and period default to 262144.
+ * The --dynamic option instead updates the code after every byte with dynamic Huffman coding (see DynamicCodeTree.hpp),
+ * so the code is never stale and there are no full rebuilds, and it is not accepted with the options that tune rebuilds.
+ * The --lag option makes each regenerated code take effect N bytes after its point, so that the code is regenerated
+ * on another thread while coding continues with the old one (4096 is a reasonable lag). Non-default options are recorded in a header, so the decompressor needs no options;
+ * with none, the output is in the original headerless format.
  * 
  * Copyright (c) Project Nayuki
  * 
@@ -17,28 +27,47 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
-#include <vector>
+#include "AdaptiveModel.hpp"
 #include "BitIoStream.hpp"
-#include "FrequencyTable.hpp"
-#include "HuffmanCoder.hpp"
+#include "CommandLine.hpp"
 
 using std::uint32_t;
 
 
-static bool isPowerOf2(uint32_t x);
+static bool parseRebuildOption(const char *arg, AdaptiveSettings &settings);
 
 
 int main(int argc, char *argv[]) {
 	// Handle command line arguments
-	if (argc != 3) {
-		std::cerr << "Usage: " << argv[0] << " InputFile OutputFile" << std::endl;
+	AdaptiveSettings settings;
+	bool tuned = false;
+	int argi = 1;
+	for (; argi < argc && std::strncmp(argv[argi], "--", 2) == 0; argi++) {
+		const char *arg = argv[argi];
+		if (std::strcmp(arg, "--dynamic") == 0 && settings.mode == AdaptiveSettings::MODE_REBUILD)
+			settings.mode = AdaptiveSettings::MODE_DYNAMIC;
+		else if (CommandLine::parseUint32Option(arg, "--lag=", 1, settings.lag) && settings.mode != AdaptiveSettings::MODE_DYNAMIC)
+			settings.mode = AdaptiveSettings::MODE_PIPELINED;
+		else if (parseRebuildOption(arg, settings))
+			tuned = true;
+		else {
+			argi = argc;  // Show usage
+			break;
+		}
+	}
+	// Dynamic coding has no rebuilds, so it would ignore the options that tune them
+	bool dynamic = settings.mode == AdaptiveSettings::MODE_DYNAMIC;
+	if (argc - argi != 2 || !settings.isValid() || (dynamic && tuned)) {
+		std::cerr << "Usage: " << argv[0] << " [--dynamic | --lag=N] [--schedule=doubling|fixed] [--interval=N]"
+			<< " [--aging=reset|halve|window] [--period=N] InputFile OutputFile" << std::endl;
 		return EXIT_FAILURE;
 	}
-	const char *inputFile  = argv[1];
-	const char *outputFile = argv[2];
+	const char *inputFile  = argv[argi];
+	const char *outputFile = argv[argi + 1];
 	
 	// Perform file compression
 	std::ifstream in(inputFile, std::ios::binary);
@@ -46,12 +75,8 @@ int main(int argc, char *argv[]) {
 	BitOutputStream bout(out);
 	try {
 		
-		const std::vector<uint32_t> initFreqs(257, 1);
-		FrequencyTable freqs(initFreqs);
-		HuffmanEncoder enc(bout);
-		CodeTree tree = freqs.buildCodeTree();  // Don't need to make canonical code because we don't transmit the code tree
-		enc.codeTree = &tree;
-		uint32_t count = 0;  // Number of bytes read from the input file
+		settings.writeHeader(bout);
+		AdaptiveModel model(settings);  // Don't need to make canonical code because we don't transmit the code tree
 		while (true) {
 			// Read and encode one byte
 			int symbol = in.get();
@@ -59,18 +84,13 @@ int main(int argc, char *argv[]) {
 				break;
 			if (symbol < 0 || symbol > 255)
 				throw std::logic_error("Assertion error");
-			enc.write(static_cast<uint32_t>(symbol));
-			count++;
+			model.write(bout, static_cast<uint32_t>(symbol));
 			
-			// Update the frequency table and possibly the code tree
-			freqs.increment(static_cast<uint32_t>(symbol));
-			if ((count < 262144 && isPowerOf2(count)) || count % 262144 == 0)  // Update code tree
-				tree = freqs.buildCodeTree();
-			if (count % 262144 == 0)  // Reset frequency table
-				freqs = FrequencyTable(initFreqs);
+			// Update the frequency table and possibly the code
+			model.update(static_cast<uint32_t>(symbol));
 		}
 		
-		enc.write(256);  // EOF
+		model.write(bout, 256);  // EOF
 		bout.finish();
 		return EXIT_SUCCESS;
 		
@@ -81,6 +101,21 @@ int main(int argc, char *argv[]) {
 }
 
 
-static bool isPowerOf2(uint32_t x) {
-	return x > 0 && (x & (x - 1)) == 0;
+// Parses the given argument if it is one of the options that tune code rebuilds (--schedule, --aging,
+// --interval, --period) and stores its value in the given settings. Returns whether it was one of them.
+static bool parseRebuildOption(const char *arg, AdaptiveSettings &settings) {
+	if (std::strcmp(arg, "--schedule=doubling") == 0)
+		settings.schedule = AdaptiveSettings::SCHEDULE_DOUBLING;
+	else if (std::strcmp(arg, "--schedule=fixed") == 0)
+		settings.schedule = AdaptiveSettings::SCHEDULE_FIXED;
+	else if (std::strcmp(arg, "--aging=reset") == 0)
+		settings.aging = AdaptiveSettings::AGING_RESET;
+	else if (std::strcmp(arg, "--aging=halve") == 0)
+		settings.aging = AdaptiveSettings::AGING_HALVE;
+	else if (std::strcmp(arg, "--aging=window") == 0)
+		settings.aging = AdaptiveSettings::AGING_WINDOW;
+	else
+		return CommandLine::parseUint32Option(arg, "--interval=", 1, settings.interval)
+			|| CommandLine::parseUint32Option(arg, "--period=", 1, settings.period);
+	return true;
 }
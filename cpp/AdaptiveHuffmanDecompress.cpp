@@ -3,6 +3,7 @@
  * 
  * Usage: AdaptiveHuffmanDecompress InputFile OutputFile
  * This decompresses files generated by the "AdaptiveHuffmanCompress" application.
+ * The settings that the compressor was given are read from the header of the file, if it has one.
  * 
  * Copyright (c) Project Nayuki
  * 
@@ -15,15 +16,13 @@
 #include <fstream>
 #include <iostream>
 #include <limits>
-#include <vector>
+#include "AdaptiveModel.hpp"
 #include "BitIoStream.hpp"
-#include "FrequencyTable.hpp"
-#include "HuffmanCoder.hpp"
 
 using std::uint32_t;
 
 
-static bool isPowerOf2(uint32_t x);
+static void writeByte(std::ostream &out, uint32_t symbol);
 
 
 int main(int argc, char *argv[]) {
@@ -41,29 +40,16 @@ int main(int argc, char *argv[]) {
 	BitInputStream bin(in);
 	try {
 		
-		const std::vector<uint32_t> initFreqs(257, 1);
-		FrequencyTable freqs(initFreqs);
-		HuffmanDecoder dec(bin);
-		CodeTree tree = freqs.buildCodeTree();  // Use same algorithm as the compressor
-		dec.codeTree = &tree;
-		uint32_t count = 0;  // Number of bytes written to the output file
+		AdaptiveModel model(AdaptiveSettings::readHeader(bin));  // Use same algorithm as the compressor
 		while (true) {
 			// Decode and write one byte
-			uint32_t symbol = dec.read();
+			uint32_t symbol = model.read(bin);
 			if (symbol == 256)  // EOF symbol
 				break;
-			int b = static_cast<int>(symbol);
-			if (std::numeric_limits<char>::is_signed)
-				b -= (b >> 7) << 8;
-			out.put(static_cast<char>(b));
-			count++;
+			writeByte(out, symbol);
 			
-			// Update the frequency table and possibly the code tree
-			freqs.increment(symbol);
-			if ((count < 262144 && isPowerOf2(count)) || count % 262144 == 0)  // Update code tree
-				tree = freqs.buildCodeTree();
-			if (count % 262144 == 0)  // Reset frequency table
-				freqs = FrequencyTable(initFreqs);
+			// Update the frequency table and possibly the code
+			model.update(symbol);
 		}
 		return EXIT_SUCCESS;
 		
@@ -74,6 +60,9 @@ int main(int argc, char *argv[]) {
 }
 
 
-static bool isPowerOf2(uint32_t x) {
-	return x > 0 && (x & (x - 1)) == 0;
+static void writeByte(std::ostream &out, uint32_t symbol) {
+	int b = static_cast<int>(symbol);
+	if (std::numeric_limits<char>::is_signed)
+		b -= (b >> 7) << 8;
+	out.put(static_cast<char>(b));
 }
@@ -0,0 +1,211 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <stdexcept>
+#include <utility>
+#include "AdaptiveModel.hpp"
+
+using std::uint8_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+
+static bool isPowerOf2(uint32_t x);
+
+
+/*---- AdaptiveSettings ----*/
+
+AdaptiveSettings::AdaptiveSettings() :
+	mode(MODE_REBUILD),
+	schedule(SCHEDULE_DOUBLING),
+	interval(DEFAULT_INTERVAL),
+	aging(AGING_RESET),
+	period(DEFAULT_PERIOD),
+	lag(DEFAULT_LAG) {}
+
+
+bool AdaptiveSettings::isDefault() const {
+	return mode == MODE_REBUILD && schedule == SCHEDULE_DOUBLING && interval == DEFAULT_INTERVAL
+		&& aging == AGING_RESET && period == DEFAULT_PERIOD;
+}
+
+
+bool AdaptiveSettings::isValid() const {
+	if (mode == MODE_DYNAMIC)
+		return true;
+	return (mode == MODE_REBUILD || (mode == MODE_PIPELINED && lag >= 1))
+		&& (schedule == SCHEDULE_DOUBLING || schedule == SCHEDULE_FIXED) && interval >= 1
+		&& (aging == AGING_RESET || aging == AGING_HALVE || aging == AGING_WINDOW) && period >= 1
+		&& (aging != AGING_WINDOW || period <= MAX_WINDOW);
+}
+
+
+void AdaptiveSettings::writeHeader(BitOutputStream &out) const {
+	if (!isValid())
+		throw std::domain_error("Invalid adaptive settings");
+	if (isDefault())
+		return;
+	for (uint8_t b : emptyStreamPrefix())
+		out.writeBits(b, 8);
+	out.writeBits(HEADER_MAGIC, 8);
+	out.writeBits(static_cast<uint32_t>(mode), 8);
+	if (mode != MODE_DYNAMIC) {
+		out.writeBits(static_cast<uint32_t>(schedule), 8);
+		out.writeBits(interval, 32);
+		out.writeBits(static_cast<uint32_t>(aging), 8);
+		out.writeBits(period, 32);
+	}
+	if (mode == MODE_PIPELINED)
+		out.writeBits(lag, 32);
+}
+
+
+AdaptiveSettings AdaptiveSettings::readHeader(BitInputStream &in) {
+	AdaptiveSettings result;
+	uint64_t expected = 0;
+	int numBits = 0;
+	for (uint8_t b : emptyStreamPrefix()) {
+		expected = expected << 8 | b;
+		numBits += 8;
+	}
+	expected = expected << 8 | HEADER_MAGIC;
+	numBits += 8;
+	if (in.peekBits(numBits) != expected)
+		return result;
+	
+	in.consumeBits(numBits);
+	result.mode = static_cast<int>(in.readBits(8));
+	if (result.mode == MODE_REBUILD || result.mode == MODE_PIPELINED) {
+		result.schedule = static_cast<int>(in.readBits(8));
+		result.interval = static_cast<uint32_t>(in.readBits(32));
+		result.aging = static_cast<int>(in.readBits(8));
+		result.period = static_cast<uint32_t>(in.readBits(32));
+	}
+	if (result.mode == MODE_PIPELINED)
+		result.lag = static_cast<uint32_t>(in.readBits(32));
+	if (!result.isValid())
+		throw std::runtime_error("Invalid stream header");
+	return result;
+}
+
+
+vector<uint8_t> AdaptiveSettings::emptyStreamPrefix() {
+	vector<uint8_t> result;
+	BitOutputStream out(result);
+	AdaptiveCoder coder(257);
+	coder.rebuild(FrequencyTable(vector<uint32_t>(257, 1)));
+	coder.write(out, 256);  // EOF
+	out.finish();
+	return result;
+}
+
+
+/*---- AdaptiveModel ----*/
+
+AdaptiveModel::AdaptiveModel(const AdaptiveSettings &sett) :
+		settings(sett),
+		count(0),
+		freqs(vector<uint32_t>(257, 1)),
+		coder(257),
+		windowIndex(0),
+		windowLength(0),
+		tree(257),
+		snapshot(freqs),
+		nextCoder(257),
+		nextCount(0) {
+	if (!settings.isValid())
+		throw std::domain_error("Invalid adaptive settings");
+	if (settings.mode != AdaptiveSettings::MODE_DYNAMIC) {
+		coder.rebuild(freqs);
+		if (settings.aging == AdaptiveSettings::AGING_WINDOW)
+			window.resize(settings.period);
+	}
+	if (settings.mode == AdaptiveSettings::MODE_PIPELINED)
+		helper.reset(new ThreadPool(1));
+}
+
+
+void AdaptiveModel::write(BitOutputStream &out, uint32_t symbol) const {
+	if (settings.mode == AdaptiveSettings::MODE_DYNAMIC)
+		tree.write(out, symbol);
+	else
+		coder.write(out, symbol);
+}
+
+
+uint32_t AdaptiveModel::read(BitInputStream &in) const {
+	if (settings.mode == AdaptiveSettings::MODE_DYNAMIC)
+		return tree.read(in);
+	else
+		return coder.read(in);
+}
+
+
+void AdaptiveModel::update(uint32_t symbol) {
+	if (symbol >= 256)
+		throw std::domain_error("Symbol out of range");
+	if (settings.mode == AdaptiveSettings::MODE_DYNAMIC) {
+		tree.increment(symbol);
+		return;
+	}
+	
+	count++;
+	freqs.increment(symbol);
+	if (settings.aging == AdaptiveSettings::AGING_WINDOW) {
+		// Once the window is full, the oldest symbol in it is no longer counted
+		if (windowLength == window.size()) {
+			uint32_t old = window[windowIndex];
+			freqs.set(old, freqs.get(old) - 1);
+		} else
+			windowLength++;
+		window[windowIndex] = static_cast<uint8_t>(symbol);
+		windowIndex++;
+		if (windowIndex == window.size())
+			windowIndex = 0;
+	}
+	
+	if (nextBuild.valid() && count == nextCount) {
+		nextBuild.get();  // Usually already finished
+		std::swap(coder, nextCoder);
+	}
+	if (count % settings.interval == 0 || (settings.schedule == AdaptiveSettings::SCHEDULE_DOUBLING
+			&& count < settings.interval && isPowerOf2(count)))
+		rebuild();
+	if (settings.aging != AdaptiveSettings::AGING_WINDOW && count % settings.period == 0)
+		age();
+}
+
+
+void AdaptiveModel::rebuild() {
+	if (settings.mode != AdaptiveSettings::MODE_PIPELINED)
+		coder.rebuild(freqs);
+	else if (!nextBuild.valid()) {
+		snapshot = freqs;
+		nextCount = count + settings.lag;
+		nextBuild = helper->submit([this]() {
+			nextCoder.rebuild(snapshot);
+		});
+	}
+}
+
+
+void AdaptiveModel::age() {
+	for (uint32_t i = 0; i < freqs.getSymbolLimit(); i++) {
+		uint64_t freq = freqs.get(i);
+		if (settings.aging == AdaptiveSettings::AGING_HALVE)
+			freqs.set(i, (freq >> 1) + (freq & 1));
+		else
+			freqs.set(i, 1);
+	}
+}
+
+
+static bool isPowerOf2(uint32_t x) {
+	return x > 0 && (x & (x - 1)) == 0;
+}
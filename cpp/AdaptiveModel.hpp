@@ -0,0 +1,202 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+#include "AdaptiveCoder.hpp"
+#include "BitIoStream.hpp"
+#include "DynamicCodeTree.hpp"
+#include "FrequencyTable.hpp"
+#include "ThreadPool.hpp"
+
+
+/* 
+ * The settings of an adaptive Huffman stream: how the code follows the statistics of the data seen so far.
+ * In the rebuild mode, the code is rebuilt from a frequency table on a schedule:
+ * - Doubling: after 1, 2, 4, 8, ... symbols while fewer than the interval, then after every multiple of the interval.
+ * - Fixed: after every multiple of the interval.
+ * Old statistics are aged after every multiple of the period:
+ * - Reset: every frequency goes back to 1.
+ * - Halve: every frequency is halved, rounding up, so recent data counts more but older data is not forgotten.
+ * - Window: instead, the frequencies always count only the last 'period' symbols (plus 1 each).
+ * The pipelined mode is the rebuild mode, except that each new code takes effect 'lag' symbols after its rebuild
+ * point, so that it can be built on another thread while the current code is still in use. A rebuild point that
+ * falls while an earlier rebuild has not yet taken effect is skipped.
+ * In the dynamic mode, the code is updated after every symbol (see DynamicCodeTree), and the other settings are unused.
+ * The defaults (rebuild mode, doubling schedule with interval 262144, reset with period 262144) give the original
+ * adaptive format, which has no header. Any other settings are recorded in a header at the start of the stream:
+ * - The encoding of an empty input in the original format (the code of the EOF symbol, padded to a byte boundary).
+ *   No stream in the original format continues after that, so the header cannot be mistaken for one.
+ * - The byte HEADER_MAGIC, then the mode (1 byte).
+ * - For the rebuild and pipelined modes, the schedule (1 byte), the interval (big-endian uint32),
+ *   the aging method (1 byte), and the period (big-endian uint32).
+ * - For the pipelined mode, the lag (big-endian uint32).
+ */
+class AdaptiveSettings final {
+	
+	/*---- Constants ----*/
+	
+	// The byte after the empty-stream prefix, which marks a header.
+	public: static const int HEADER_MAGIC = 0x41;
+	
+	// Values of the mode field.
+	public: static const int MODE_REBUILD = 0;
+	public: static const int MODE_DYNAMIC = 1;
+	public: static const int MODE_PIPELINED = 2;
+	
+	// Values of the schedule field.
+	public: static const int SCHEDULE_DOUBLING = 0;
+	public: static const int SCHEDULE_FIXED = 1;
+	
+	// Values of the aging field.
+	public: static const int AGING_RESET = 0;
+	public: static const int AGING_HALVE = 1;
+	public: static const int AGING_WINDOW = 2;
+	
+	// The default interval and period, as in the original format.
+	public: static const std::uint32_t DEFAULT_INTERVAL = 262144;
+	public: static const std::uint32_t DEFAULT_PERIOD = 262144;
+	
+	// A default lag for the pipelined mode, long enough that a rebuild usually finishes before it takes effect.
+	public: static const std::uint32_t DEFAULT_LAG = 4096;
+	
+	// The largest allowed period for the window aging method, which keeps that many symbols in memory.
+	public: static const std::uint32_t MAX_WINDOW = UINT32_C(1) << 28;
+	
+	
+	/*---- Fields ----*/
+	
+	public: int mode;
+	
+	public: int schedule;
+	
+	// The number of symbols between code rebuilds, at least 1.
+	public: std::uint32_t interval;
+	
+	public: int aging;
+	
+	// The number of symbols between agings, or the window size; at least 1.
+	public: std::uint32_t period;
+	
+	// For the pipelined mode, the number of symbols between a rebuild point and the use of its code, at least 1.
+	public: std::uint32_t lag;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Constructs the default settings, those of the original format.
+	public: explicit AdaptiveSettings();
+	
+	
+	/*---- Methods ----*/
+	
+	// Tests whether these are the default settings, which are written without a header.
+	public: bool isDefault() const;
+	
+	
+	// Tests whether every field is in range.
+	public: bool isValid() const;
+	
+	
+	// Writes the header for these settings to the given stream at its start, or nothing for the default settings.
+	// Throws domain_error if the settings are invalid.
+	public: void writeHeader(BitOutputStream &out) const;
+	
+	
+	// Reads the header at the start of the given stream and returns its settings, or returns the default
+	// settings without consuming anything if the stream has no header. Throws runtime_error if it is malformed.
+	public: static AdaptiveSettings readHeader(BitInputStream &in);
+	
+	
+	// Returns the bytes that encode an empty input in the original format, which start every header.
+	private: static std::vector<std::uint8_t> emptyStreamPrefix();
+	
+};
+
+
+
+/* 
+ * The state of an adaptive Huffman encoder or decoder for the alphabet of 256 byte values and the EOF symbol 256,
+ * following the given settings. An encoder and decoder that are updated with the same symbols stay synchronized.
+ */
+class AdaptiveModel final {
+	
+	/*---- Fields ----*/
+	
+	private: AdaptiveSettings settings;
+	
+	// The number of symbols given to update() so far, modulo 2^32 as in the original format.
+	private: std::uint32_t count;
+	
+	// The frequency table and code of the rebuild and pipelined modes. Every frequency is at least 1.
+	private: FrequencyTable freqs;
+	private: AdaptiveCoder coder;
+	
+	// For the window aging method, the last 'period' symbols in a circular buffer,
+	// the next position in it, and the number of symbols in it.
+	private: std::vector<std::uint8_t> window;
+	private: std::size_t windowIndex;
+	private: std::size_t windowLength;
+	
+	// The code of the dynamic mode.
+	private: DynamicCodeTree tree;
+	
+	// For the pipelined mode, the frequencies at the last rebuild point and the code being built from them,
+	// which belong to the helper thread while the build is pending.
+	private: FrequencyTable snapshot;
+	private: AdaptiveCoder nextCoder;
+	
+	// For the pipelined mode, the value of count at which nextCoder replaces coder, and the pending build
+	// (not valid if none).
+	private: std::uint32_t nextCount;
+	private: std::future<void> nextBuild;
+	
+	// For the pipelined mode, the helper thread, otherwise null. It is declared last so that it is destroyed first,
+	// which waits for a pending build to finish before the arrays that it uses are destroyed.
+	private: std::unique_ptr<ThreadPool> helper;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Constructs a model in the initial state for the given settings, where every symbol has frequency 1.
+	// Throws domain_error if the settings are invalid.
+	public: explicit AdaptiveModel(const AdaptiveSettings &settings);
+	
+	
+	/*---- Methods ----*/
+	
+	// Writes the current code of the given symbol to the given stream.
+	public: void write(BitOutputStream &out, std::uint32_t symbol) const;
+	
+	
+	// Reads from the given stream to decode the next symbol with the current code.
+	public: std::uint32_t read(BitInputStream &in) const;
+	
+	
+	// Counts the given byte value (not the EOF symbol) and updates the code as the settings say.
+	public: void update(std::uint32_t symbol);
+	
+	
+	// Starts building the code for the current frequencies, or builds it now if not pipelined.
+	private: void rebuild();
+	
+	
+	// Resets or halves the frequencies at the end of a period.
+	private: void age();
+	
+	
+	// Copying would share the pending build.
+	public: AdaptiveModel(const AdaptiveModel &) = delete;
+	public: AdaptiveModel &operator=(const AdaptiveModel &) = delete;
+	
+};
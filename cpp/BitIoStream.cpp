@@ -6,32 +6,39 @@
  * https://github.com/nayuki/Reference-Huffman-coding
  */
 
-#include <limits>
 #include <stdexcept>
 #include "BitIoStream.hpp"
 
 
 BitInputStream::BitInputStream(std::istream &in) :
-	input(in),
-	currentByte(0),
-	numBitsRemaining(0) {}
+	input(&in),
+	byteBuffer(BLOCK_SIZE),
+	memoryData(nullptr),
+	blockIndex(0),
+	blockLength(0),
+	bitBuffer(0),
+	bitBufferLength(0) {}
+
+
+BitInputStream::BitInputStream(const std::uint8_t *data, std::size_t length) :
+	input(nullptr),
+	memoryData(reinterpret_cast<const char*>(data)),
+	blockIndex(0),
+	blockLength(length),
+	bitBuffer(0),
+	bitBufferLength(0) {}
 	
 	
 int BitInputStream::read() {
-	if (currentByte == -1)
-		return -1;
-	if (numBitsRemaining == 0) {
-		currentByte = input.get();  // Note: istream.get() returns int, not char
-		if (currentByte == EOF)
+	if (bitBufferLength == 0) {
+		refill();
+		if (bitBufferLength == 0)
 			return -1;
-		if (currentByte < 0 || currentByte > 255)
-			throw std::logic_error("Assertion error");
-		numBitsRemaining = 8;
 	}
-	if (numBitsRemaining <= 0)
-		throw std::logic_error("Assertion error");
-	numBitsRemaining--;
-	return (currentByte >> numBitsRemaining) & 1;
+	int result = static_cast<int>(bitBuffer >> 63);
+	bitBuffer <<= 1;
+	bitBufferLength--;
+	return result;
 }
 
 
@@ -44,29 +51,85 @@ int BitInputStream::readNoEof() {
 }
 
 
+std::uint64_t BitInputStream::readBits(int n) {
+	std::uint64_t result = peekBits(n);
+	consumeBits(n);
+	return result;
+}
+
+
+void BitInputStream::refill() {
+	const char *block = input != nullptr ? byteBuffer.data() : memoryData;
+	if (blockLength - blockIndex >= 8) {
+		// Fast path: load 8 bytes at once and keep as many whole bytes as fit. The bits of the
+		// partial byte at the bottom are the true upcoming bits, so they are harmless to leave in.
+		const char *p = &block[blockIndex];
+		std::uint64_t word = 0;
+		for (int i = 0; i < 8; i++)
+			word = (word << 8) | static_cast<unsigned char>(p[i]);
+		int numBytes = (63 - bitBufferLength) >> 3;
+		bitBuffer |= word >> bitBufferLength;
+		blockIndex += static_cast<std::size_t>(numBytes);
+		bitBufferLength += numBytes * 8;
+		return;
+	}
+	while (bitBufferLength <= MAX_PEEK_BITS) {
+		if (blockIndex == blockLength) {
+			if (input == nullptr)
+				break;  // End of memory buffer
+			input->read(byteBuffer.data(), static_cast<std::streamsize>(byteBuffer.size()));
+			blockIndex = 0;
+			blockLength = static_cast<std::size_t>(input->gcount());
+			if (blockLength == 0)
+				break;  // End of stream
+		}
+		// Note: char may be signed, so convert through unsigned char
+		std::uint64_t b = static_cast<unsigned char>(block[blockIndex]);
+		blockIndex++;
+		bitBuffer |= b << (56 - bitBufferLength);
+		bitBufferLength += 8;
+	}
+}
+
+
 BitOutputStream::BitOutputStream(std::ostream &out) :
-	output(out),
-	currentByte(0),
-	numBitsFilled(0) {}
+		output(&out),
+		memoryOutput(nullptr),
+		accumulator(0),
+		numBitsFilled(0) {
+	byteBuffer.reserve(BLOCK_SIZE);
+}
+
+
+BitOutputStream::BitOutputStream(std::vector<std::uint8_t> &out) :
+		output(nullptr),
+		memoryOutput(&out),
+		accumulator(0),
+		numBitsFilled(0) {}
 
 
 void BitOutputStream::write(int b) {
 	if (b != 0 && b != 1)
 		throw std::domain_error("Argument must be 0 or 1");
-	currentByte = (currentByte << 1) | b;
-	numBitsFilled++;
-	if (numBitsFilled == 8) {
-		// Note: ostream.put() takes char, which may be signed/unsigned
-		if (std::numeric_limits<char>::is_signed)
-			currentByte -= (currentByte >> 7) << 8;
-		output.put(static_cast<char>(currentByte));
-		currentByte = 0;
-		numBitsFilled = 0;
-	}
+	appendBits(static_cast<std::uint64_t>(b), 1);
 }
 
 
 void BitOutputStream::finish() {
-	while (numBitsFilled != 0)
-		write(0);
+	if (numBitsFilled % 8 != 0)
+		appendBits(0, 8 - numBitsFilled % 8);
+	std::vector<std::uint8_t> &bytes = memoryOutput != nullptr ? *memoryOutput : byteBuffer;
+	while (numBitsFilled > 0) {
+		numBitsFilled -= 8;
+		bytes.push_back(static_cast<std::uint8_t>(accumulator >> numBitsFilled));
+	}
+	accumulator = 0;
+	flushBuffer();
+}
+
+
+void BitOutputStream::flushBuffer() {
+	if (output != nullptr)
+		output->write(reinterpret_cast<const char*>(byteBuffer.data()), static_cast<std::streamsize>(byteBuffer.size()));
+	byteBuffer.clear();
 }
@@ -8,34 +8,68 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <istream>
 #include <ostream>
+#include <stdexcept>
+#include <vector>
 
 
 /* 
- * A stream of bits that can be read. Because they come from an underlying byte stream,
- * the total number of bits is always a multiple of 8. The bits are read in big endian.
+ * A stream of bits that can be read. Because they come from an underlying byte stream
+ * or memory buffer, the total number of bits is always a multiple of 8. The bits are read
+ * in big endian. Bytes are fetched from the underlying stream in large blocks and then
+ * shifted into a 64-bit buffer, so the underlying stream may be read ahead of the bits
+ * consumed so far.
  */
 class BitInputStream final {
 	
+	/*---- Constants ----*/
+	
+	// The maximum number of bits that can be peeked or consumed in one call.
+	public: static const int MAX_PEEK_BITS = 56;
+	
+	// The number of bytes requested from the underlying stream in each block read.
+	private: static const std::size_t BLOCK_SIZE = 65536;
+	
+	
 	/*---- Fields ----*/
 	
-	// The underlying byte stream to read from.
-	private: std::istream &input;
+	// The underlying byte stream to read from, or null if reading from a memory buffer.
+	private: std::istream *input;
+	
+	// The most recent block of bytes read from the underlying stream. Unused when reading from memory.
+	private: std::vector<char> byteBuffer;
+	
+	// The memory buffer to read from, or null if reading from an underlying stream.
+	private: const char *memoryData;
 	
-	// Either in the range [0x00, 0xFF] if bits are available, or -1 if end of stream is reached.
-	private: int currentByte;
+	// Index of the next unused byte in the current block, always between 0 and blockLength (inclusive).
+	private: std::size_t blockIndex;
 	
-	// Number of remaining bits in the current byte, always between 0 and 7 (inclusive).
-	private: int numBitsRemaining;
+	// Number of valid bytes in the current block, which is either byteBuffer or all of memoryData.
+	private: std::size_t blockLength;
 	
+	// The next bits to be read, aligned to the most significant end. The bits after
+	// the first bitBufferLength bits are either 0 or equal to the upcoming bits of the stream.
+	private: std::uint64_t bitBuffer;
 	
-	/*---- Constructor ----*/
+	// Number of valid bits in bitBuffer, always between 0 and 64 (inclusive).
+	private: int bitBufferLength;
+	
+	
+	/*---- Constructors ----*/
 	
 	// Constructs a bit input stream based on the given byte input stream.
 	public: explicit BitInputStream(std::istream &in);
 	
 	
+	// Constructs a bit input stream that reads the given array of bytes, which must stay valid
+	// for the lifetime of this object. The end of stream is reached after the given number of bytes.
+	public: explicit BitInputStream(const std::uint8_t *data, std::size_t length);
+	
+	
 	/*---- Methods ----*/
 	
 	// Reads a bit from this stream. Returns 0 or 1 if a bit is available, or -1 if
@@ -47,45 +81,157 @@ class BitInputStream final {
 	// if the end of stream is reached. The end of stream always occurs on a byte boundary.
 	public: int readNoEof();
 	
+	
+	// Returns the next n bits of this stream as a big-endian integer without consuming them,
+	// where 0 <= n <= MAX_PEEK_BITS. Positions past the end of stream are read as 0 bits.
+	public: std::uint64_t peekBits(int n);
+	
+	
+	// Discards the next n bits of this stream, where 0 <= n <= MAX_PEEK_BITS.
+	// Throws an exception if fewer than n bits remain before the end of stream.
+	public: void consumeBits(int n);
+	
+	
+	// Reads the next n bits of this stream as a big-endian integer, where 0 <= n <= MAX_PEEK_BITS.
+	// Throws an exception if fewer than n bits remain before the end of stream.
+	public: std::uint64_t readBits(int n);
+	
+	
+	// Tops up the bit buffer to more than MAX_PEEK_BITS bits, or to all the remaining bits
+	// if the end of stream is reached first. Reads the next block from the underlying stream as needed.
+	private: void refill();
+	
 };
 
 
 
+// Inline definitions, because these methods are called once per decoded symbol.
+
+inline std::uint64_t BitInputStream::peekBits(int n) {
+	if (n < 0 || n > MAX_PEEK_BITS)
+		throw std::domain_error("Bit count out of range");
+	if (bitBufferLength < n)
+		refill();
+	return n > 0 ? bitBuffer >> (64 - n) : 0;
+}
+
+
+inline void BitInputStream::consumeBits(int n) {
+	if (n < 0 || n > MAX_PEEK_BITS)
+		throw std::domain_error("Bit count out of range");
+	if (bitBufferLength < n) {
+		refill();
+		if (bitBufferLength < n)
+			throw std::runtime_error("End of stream");
+	}
+	bitBuffer <<= n;
+	bitBufferLength -= n;
+}
+
+
+
 /* 
- * A stream where bits can be written to. Because they are written to an underlying
- * byte stream, the end of the stream is padded with 0's up to a multiple of 8 bits.
- * The bits are written in big endian.
+ * A stream where bits can be written to. Because they are written to an underlying byte
+ * stream or byte vector, the end of the stream is padded with 0's up to a multiple of 8 bits.
+ * The bits are written in big endian. Bits are gathered in a 64-bit accumulator and
+ * moved as whole 32-bit words into an internal byte buffer, which is passed on to the
+ * underlying stream or vector whenever it becomes full and when finish() is called.
  */
 class BitOutputStream final {
 	
+	/*---- Constant ----*/
+	
+	// The number of buffered bytes at which the buffer is written to the underlying stream.
+	private: static const std::size_t BLOCK_SIZE = 65536;
+	
+	
 	/*---- Fields ----*/
 	
-	// The underlying byte stream to write to.
-	private: std::ostream &output;
+	// The underlying byte stream to write to, or null if writing to a byte vector.
+	private: std::ostream *output;
 	
-	// The accumulated bits for the current byte, always in the range [0x00, 0xFF].
-	private: int currentByte;
+	// The byte vector to append to, or null if writing to an underlying stream. Whole words are appended
+	// to it directly, so a vector with enough reserved capacity is never reallocated or copied.
+	private: std::vector<std::uint8_t> *memoryOutput;
 	
-	// Number of accumulated bits in the current byte, always between 0 and 7 (inclusive).
+	// Whole bytes that have been produced but not yet written to the underlying stream. Unused for a byte vector.
+	private: std::vector<std::uint8_t> byteBuffer;
+	
+	// The accumulated bits that do not yet form a whole word, right-aligned. Always less than 2^numBitsFilled.
+	private: std::uint64_t accumulator;
+	
+	// Number of accumulated bits in the accumulator, always between 0 and 31 (inclusive).
 	private: int numBitsFilled;
 	
 	
-	/*---- Constructor ----*/
+	/*---- Constructors ----*/
 	
 	// Constructs a bit output stream based on the given byte output stream.
 	public: explicit BitOutputStream(std::ostream &out);
 	
 	
+	// Constructs a bit output stream that appends bytes to the given vector, which
+	// must stay valid for the lifetime of this object. Existing contents are kept.
+	public: explicit BitOutputStream(std::vector<std::uint8_t> &out);
+	
+	
 	/*---- Methods ----*/
 	
 	// Writes a bit to the stream. The given bit must be 0 or 1.
 	public: void write(int b);
 	
 	
+	// Writes the low n bits of the given value to the stream in big endian, where 0 <= n <= 64.
+	// The value must be less than 2^n, i.e. all bits above the lowest n bits must be 0.
+	public: void writeBits(std::uint64_t bits, int n);
+	
+	
 	// Writes the minimum number of "0" bits (between 0 and 7 of them) as padding to
-	// reach the next byte boundary. Most applications will require the bits in the last
-	// partial byte to be written before the underlying stream is closed. Note that this
-	// method merely writes data to the underlying output stream but does not close it.
+	// reach the next byte boundary, then writes all buffered bytes to the underlying stream or vector.
+	// Most applications will require the bits in the last partial byte to be written before
+	// the underlying stream is closed. Note that this method merely writes data to the
+	// underlying output stream but does not close it.
 	public: void finish();
 	
+	
+	// Appends the given bits to the accumulator, where 0 <= n <= 32 and bits < 2^n.
+	private: void appendBits(std::uint64_t bits, int n);
+	
+	
+	// Writes all bytes in the byte buffer to the underlying stream, if any, and clears the buffer.
+	private: void flushBuffer();
+	
 };
+
+
+
+inline void BitOutputStream::writeBits(std::uint64_t bits, int n) {
+	if (n < 0 || n > 64)
+		throw std::domain_error("Bit count out of range");
+	if (n < 64 && (bits >> n) != 0)
+		throw std::domain_error("Value has more than the given number of bits");
+	if (n > 32) {
+		appendBits(bits >> 32, n - 32);
+		bits &= UINT32_MAX;
+		n = 32;
+	}
+	appendBits(bits, n);
+}
+
+
+inline void BitOutputStream::appendBits(std::uint64_t bits, int n) {
+	accumulator = (accumulator << n) | bits;
+	numBitsFilled += n;
+	if (numBitsFilled >= 32) {
+		numBitsFilled -= 32;
+		std::uint64_t word = accumulator >> numBitsFilled;
+		std::vector<std::uint8_t> &bytes = memoryOutput != nullptr ? *memoryOutput : byteBuffer;
+		bytes.push_back(static_cast<std::uint8_t>(word >> 24));
+		bytes.push_back(static_cast<std::uint8_t>(word >> 16));
+		bytes.push_back(static_cast<std::uint8_t>(word >>  8));
+		bytes.push_back(static_cast<std::uint8_t>(word >>  0));
+		accumulator &= (static_cast<std::uint64_t>(1) << numBitsFilled) - 1;
+		if (byteBuffer.size() >= BLOCK_SIZE)
+			flushBuffer();
+	}
+}
@@ -11,47 +11,53 @@
 #include <stdexcept>
 #include <utility>
 #include "CanonicalCode.hpp"
+#include "DecodeTable.hpp"
+#include "EncodeTable.hpp"
+#include "FrequencyTable.hpp"
 
 using std::uint32_t;
+using std::uint64_t;
 using std::vector;
 
 
-CanonicalCode::CanonicalCode(const vector<uint32_t> &codeLens) {
+// The order in which the compact format stores the meta-code lengths.
+static const uint32_t META_LENGTH_ORDER[CanonicalCode::NUM_META_SYMBOLS] = {
+	18, 19, 0, 17, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15, 16};
+
+
+CanonicalCode::CanonicalCode(const vector<uint32_t> &codeLens) :
+		codeLengths(codeLens) {
 	// Check basic validity
 	if (codeLens.size() < 2)
 		throw std::invalid_argument("At least 2 symbols needed");
 	if (codeLens.size() > UINT32_MAX)
 		throw std::length_error("Too many symbols");
 	
-	// Copy once and check for tree validity
-	codeLengths = codeLens;
-	std::sort(codeLengths.begin(), codeLengths.end(), std::greater<uint32_t>());
-	uint32_t currentLevel = codeLengths.front();
-	uint32_t numNodesAtLevel = 0;
+	// A full code tree with k leaves is at most k - 1 levels deep, so a longer code means that some
+	// level below has an odd number of nodes. This also bounds the size of numCodesOfLength.
+	uint32_t maxCodeLength = 0;
+	std::size_t numCodes = 0;
 	for (uint32_t cl : codeLengths) {
-		if (cl == 0)
-			break;
-		while (cl < currentLevel) {
-			if (numNodesAtLevel % 2 != 0)
-				throw std::invalid_argument("Under-full Huffman code tree");
-			numNodesAtLevel /= 2;
-			currentLevel--;
-		}
-		numNodesAtLevel++;
+		maxCodeLength = std::max(cl, maxCodeLength);
+		if (cl > 0)
+			numCodes++;
 	}
-	while (currentLevel > 0) {
+	if (maxCodeLength >= numCodes)
+		throw std::invalid_argument("Under-full Huffman code tree");
+	countCodeLengths(maxCodeLength);
+	
+	// Check for tree validity by pairing up the nodes at each level, from the deepest level upward
+	uint64_t numNodesAtLevel = 0;
+	for (uint32_t i = maxCodeLength; i > 0; i--) {
+		numNodesAtLevel += numCodesOfLength.at(i);
 		if (numNodesAtLevel % 2 != 0)
 			throw std::invalid_argument("Under-full Huffman code tree");
 		numNodesAtLevel /= 2;
-		currentLevel--;
 	}
 	if (numNodesAtLevel < 1)
 		throw std::invalid_argument("Under-full Huffman code tree");
 	if (numNodesAtLevel > 1)
 		throw std::invalid_argument("Over-full Huffman code tree");
-	
-	// Copy again
-	codeLengths = codeLens;
 }
 
 
@@ -59,29 +65,37 @@ CanonicalCode::CanonicalCode(const CodeTree &tree, uint32_t symbolLimit) {
 	if (symbolLimit < 2)
 		throw std::invalid_argument("At least 2 symbols needed");
 	codeLengths = vector<uint32_t>(symbolLimit, 0);
-	buildCodeLengths(&tree.root, 0);
+	buildCodeLengths(tree, tree.getRoot(), 0);
+	countCodeLengths(*std::max_element(codeLengths.cbegin(), codeLengths.cend()));
 }
 
 
-void CanonicalCode::buildCodeLengths(const Node *node, uint32_t depth) {
-	if (dynamic_cast<const InternalNode*>(node) != nullptr) {
-		const InternalNode *internalNode = dynamic_cast<const InternalNode*>(node);
-		buildCodeLengths(internalNode->leftChild .get(), depth + 1);
-		buildCodeLengths(internalNode->rightChild.get(), depth + 1);
-	} else if (dynamic_cast<const Leaf*>(node) != nullptr) {
-		uint32_t symbol = dynamic_cast<const Leaf*>(node)->symbol;
-		if (symbol >= codeLengths.size())
-			throw std::invalid_argument("Symbol exceeds symbol limit");
-		// Note: CodeTree already has a checked constraint that disallows a symbol in multiple leaves
-		if (codeLengths.at(symbol) != 0)
-			throw std::logic_error("Assertion error: Symbol has more than one code");
-		codeLengths.at(symbol) = depth;
-	} else {
-		throw std::logic_error("Assertion error: Illegal node type");
+void CanonicalCode::buildCodeLengths(const CodeTree &tree, uint32_t node, uint32_t depth) {
+	for (int bit = 0; bit < 2; bit++) {
+		uint32_t entry = tree.getChild(node, bit);
+		if (!CodeTree::isLeaf(entry))
+			buildCodeLengths(tree, entry, depth + 1);
+		else {
+			uint32_t symbol = CodeTree::getSymbol(entry);
+			if (symbol >= codeLengths.size())
+				throw std::invalid_argument("Symbol exceeds symbol limit");
+			// Note: CodeTree already has a checked constraint that disallows a symbol in multiple leaves
+			if (codeLengths.at(symbol) != 0)
+				throw std::logic_error("Assertion error: Symbol has more than one code");
+			codeLengths.at(symbol) = depth + 1;
+		}
 	}
 }
 
 
+void CanonicalCode::countCodeLengths(uint32_t maxCodeLength) {
+	numCodesOfLength = vector<uint32_t>(maxCodeLength + 1, 0);
+	for (uint32_t cl : codeLengths)
+		numCodesOfLength.at(cl)++;
+	numCodesOfLength.at(0) = 0;
+}
+
+
 uint32_t CanonicalCode::getSymbolLimit() const {
 	return static_cast<uint32_t>(codeLengths.size());
 }
@@ -94,40 +108,161 @@ uint32_t CanonicalCode::getCodeLength(uint32_t symbol) const {
 }
 
 
+uint32_t CanonicalCode::getMaxCodeLength() const {
+	return static_cast<uint32_t>(numCodesOfLength.size() - 1);
+}
+
+
+uint32_t CanonicalCode::getNumCodesOfLength(uint32_t length) const {
+	if (length == 0)
+		throw std::domain_error("Code length must be positive");
+	return length < numCodesOfLength.size() ? numCodesOfLength[length] : 0;
+}
+
+
+vector<uint32_t> CanonicalCode::getSymbolsInCodeOrder() const {
+	// Counting sort by code length, which keeps each length's symbols in ascending order
+	vector<std::size_t> nextIndex(numCodesOfLength.size(), 0);
+	for (std::size_t i = 1; i + 1 < numCodesOfLength.size(); i++)
+		nextIndex[i + 1] = nextIndex[i] + numCodesOfLength[i];
+	vector<uint32_t> result(nextIndex.back() + numCodesOfLength.back());
+	uint32_t symbol = 0;
+	for (uint32_t cl : codeLengths) {
+		if (cl > 0) {
+			result[nextIndex[cl]] = symbol;
+			nextIndex[cl]++;
+		}
+		symbol++;
+	}
+	return result;
+}
+
+
 CodeTree CanonicalCode::toCodeTree() const {
-	vector<std::unique_ptr<Node> > nodes;
-	for (uint32_t i = *std::max_element(codeLengths.cbegin(), codeLengths.cend()); ; i--) {  // Descend through code lengths
-		if (nodes.size() % 2 != 0)
+	// Build the tree bottom-up, one level at a time. At each depth, the leaves come first (left), in
+	// ascending symbol order, followed by the internal nodes formed by pairing up the deeper level.
+	const vector<uint32_t> sortedSymbols = getSymbolsInCodeOrder();
+	std::size_t leafEnd = sortedSymbols.size();
+	vector<uint32_t> nodes;  // Child entries of the internal nodes, as in CodeTree
+	nodes.reserve((sortedSymbols.size() - 1) * 2);
+	vector<uint32_t> layer;  // Entries of the nodes at the current depth, from left to right
+	for (uint32_t i = getMaxCodeLength(); ; i--) {  // Descend through code lengths
+		if (layer.size() % 2 != 0)
 			throw std::logic_error("Assertion error: Violation of canonical code invariants");
-		vector<std::unique_ptr<Node> > newNodes;
+		vector<uint32_t> newLayer;
 		
 		// Add leaves for symbols with positive code length i
 		if (i > 0) {
-			uint32_t j = 0;
-			for (uint32_t cl : codeLengths) {
-				if (cl == i)
-					newNodes.push_back(std::unique_ptr<Node>(new Leaf(j)));
-				j++;
-			}
+			std::size_t leafStart = leafEnd - numCodesOfLength[i];
+			for (std::size_t j = leafStart; j < leafEnd; j++)
+				newLayer.push_back(sortedSymbols[j] | CodeTree::LEAF_FLAG);
+			leafEnd = leafStart;
 		}
 		
 		// Merge pairs of nodes from the previous deeper layer
-		for (std::size_t j = 0; j < nodes.size(); j += 2) {
-			newNodes.push_back(std::unique_ptr<Node>(new InternalNode(
-				std::move(nodes.at(j)), std::move(nodes.at(j + 1)))));
+		for (std::size_t j = 0; j < layer.size(); j += 2) {
+			nodes.push_back(layer[j]);
+			nodes.push_back(layer[j + 1]);
+			newLayer.push_back(static_cast<uint32_t>(nodes.size() / 2 - 1));
 		}
-		nodes = std::move(newNodes);
+		layer = std::move(newLayer);
 		
 		if (i == 0)
 			break;
 	}
 	
-	if (nodes.size() != 1)
+	if (layer.size() != 1)
 		throw std::logic_error("Assertion error: Violation of canonical code invariants");
+	return CodeTree(std::move(nodes), static_cast<uint32_t>(codeLengths.size()));
+}
+
+
+void CanonicalCode::writeCompact(BitOutputStream &out) const {
+	if (getMaxCodeLength() > 255)
+		throw std::domain_error("The code for a symbol is too long");
 	
-	Node *temp = nodes.front().release();
-	InternalNode *root = dynamic_cast<InternalNode*>(temp);
-	CodeTree result(std::move(*root), static_cast<uint32_t>(codeLengths.size()));
-	delete root;
-	return result;
+	// Run-length encode the code lengths into meta-symbols, each packed as (extraBits << 16) | (numExtraBits << 8) | symbol
+	vector<uint32_t> metaSymbols;
+	for (std::size_t i = 0; i < codeLengths.size(); ) {
+		uint32_t len = codeLengths[i];
+		std::size_t run = 1;
+		while (i + run < codeLengths.size() && codeLengths[i + run] == len && run < 138)
+			run++;
+		if (len == 0 && run >= 11) {
+			metaSymbols.push_back(static_cast<uint32_t>(run - 11) << 16 | 7 << 8 | 19);
+			i += run;
+		} else if (len == 0 && run >= 3) {
+			metaSymbols.push_back(static_cast<uint32_t>(run - 3) << 16 | 3 << 8 | 18);
+			i += run;
+		} else if (len > 0 && i > 0 && codeLengths[i - 1] == len && run >= 3) {
+			run = std::min(run, static_cast<std::size_t>(6));
+			metaSymbols.push_back(static_cast<uint32_t>(run - 3) << 16 | 2 << 8 | 17);
+			i += run;
+		} else {
+			metaSymbols.push_back(len <= 15 ? len : (len << 16 | 8 << 8 | 16));
+			i++;
+		}
+	}
+	
+	// Build the meta-code from the meta-symbol frequencies
+	FrequencyTable freqs(vector<uint32_t>(NUM_META_SYMBOLS, 0));
+	for (uint32_t meta : metaSymbols)
+		freqs.increment(meta & 0xFF);
+	const CanonicalCode metaCode(freqs.buildCodeLengths(MAX_META_CODE_LENGTH));
+	
+	// Write the meta-code lengths, omitting trailing zeros
+	uint32_t numMetaLengths = NUM_META_SYMBOLS;
+	while (numMetaLengths > 4 && metaCode.getCodeLength(META_LENGTH_ORDER[numMetaLengths - 1]) == 0)
+		numMetaLengths--;
+	out.writeBits(numMetaLengths - 4, 5);
+	for (uint32_t i = 0; i < numMetaLengths; i++)
+		out.writeBits(metaCode.getCodeLength(META_LENGTH_ORDER[i]), 3);
+	
+	// Write the meta-symbols and their extra bits
+	const EncodeTable table(metaCode);
+	for (uint32_t meta : metaSymbols) {
+		table.write(out, meta & 0xFF);
+		int numExtraBits = static_cast<int>((meta >> 8) & 0xFF);
+		if (numExtraBits > 0)
+			out.writeBits(meta >> 16, numExtraBits);
+	}
+}
+
+
+CanonicalCode CanonicalCode::readCompact(BitInputStream &in, uint32_t symbolLimit) {
+	// Read the meta-code
+	vector<uint32_t> metaCodeLengths(NUM_META_SYMBOLS, 0);
+	uint32_t numMetaLengths = static_cast<uint32_t>(in.readBits(5)) + 4;
+	if (numMetaLengths > NUM_META_SYMBOLS)
+		throw std::runtime_error("Invalid code length header");
+	for (uint32_t i = 0; i < numMetaLengths; i++)
+		metaCodeLengths[META_LENGTH_ORDER[i]] = static_cast<uint32_t>(in.readBits(3));
+	const CanonicalCode metaCode(metaCodeLengths);
+	const DecodeTable table(metaCode, static_cast<int>(MAX_META_CODE_LENGTH));
+	
+	// Decode the meta-symbols into code lengths
+	vector<uint32_t> codeLens;
+	codeLens.reserve(symbolLimit);
+	while (codeLens.size() < symbolLimit) {
+		uint32_t meta = table.read(in);
+		uint32_t len = 0;
+		std::size_t run = 1;
+		if (meta <= 15)
+			len = meta;
+		else if (meta == 16)
+			len = static_cast<uint32_t>(in.readBits(8));
+		else if (meta == 17) {
+			if (codeLens.empty() || codeLens.back() == 0)
+				throw std::runtime_error("Invalid code length header");
+			len = codeLens.back();
+			run = static_cast<std::size_t>(in.readBits(2)) + 3;
+		} else if (meta == 18)
+			run = static_cast<std::size_t>(in.readBits(3)) + 3;
+		else  // meta == 19
+			run = static_cast<std::size_t>(in.readBits(7)) + 11;
+		if (run > symbolLimit - codeLens.size())
+			throw std::runtime_error("Invalid code length header");
+		codeLens.insert(codeLens.end(), run, len);
+	}
+	return CanonicalCode(codeLens);
 }
@@ -10,6 +10,7 @@
 
 #include <cstdint>
 #include <vector>
+#include "BitIoStream.hpp"
 #include "CodeTree.hpp"
 
 
@@ -49,10 +50,25 @@
  */
 class CanonicalCode final {
 	
-	/*---- Field ----*/
+	/*---- Constants ----*/
+	
+	// The number of symbols in the meta-alphabet of the compact code length format (see writeCompact()).
+	public: static const std::uint32_t NUM_META_SYMBOLS = 20;
+	
+	// The longest code length in the meta-code of the compact format.
+	public: static const std::uint32_t MAX_META_CODE_LENGTH = 7;
+	
+	
+	/*---- Fields ----*/
 	
 	private: std::vector<std::uint32_t> codeLengths;
 	
+	// numCodesOfLength[i] is the number of symbols with code length i, except that numCodesOfLength[0] is 0.
+	// Its size is the longest code length plus 1. Together with the code lengths, this determines every code:
+	// the first code of each length is the code after the last code of the previous length, shifted left by one,
+	// and within each length the codes are consecutive integers assigned to symbols in ascending order.
+	private: std::vector<std::uint32_t> numCodesOfLength;
+	
 	
 	
 	/*---- Constructors ----*/
@@ -79,7 +95,11 @@ class CanonicalCode final {
 	
 	
 	// Recursive helper method for the above constructor.
-	private: void buildCodeLengths(const Node *node, std::uint32_t depth);
+	private: void buildCodeLengths(const CodeTree &tree, std::uint32_t node, std::uint32_t depth);
+	
+	
+	// Fills numCodesOfLength from codeLengths, whose longest length must be the given value.
+	private: void countCodeLengths(std::uint32_t maxCodeLength);
 	
 	
 	
@@ -95,7 +115,46 @@ class CanonicalCode final {
 	public: std::uint32_t getCodeLength(std::uint32_t symbol) const;
 	
 	
+	// Returns the longest code length of any symbol. The result is always at least 1.
+	public: std::uint32_t getMaxCodeLength() const;
+	
+	
+	// Returns the number of symbols with the given code length, which must be positive.
+	// The result is 0 for lengths longer than getMaxCodeLength().
+	public: std::uint32_t getNumCodesOfLength(std::uint32_t length) const;
+	
+	
+	// Returns all symbols that have a code, sorted by ascending code length and then by ascending
+	// symbol value, which is also the order of ascending code values. Takes linear time.
+	public: std::vector<std::uint32_t> getSymbolsInCodeOrder() const;
+	
+	
 	// Returns the canonical code tree for this canonical Huffman code.
 	public: CodeTree toCodeTree() const;
 	
+	
+	/*---- Compact serialization ----*/
+	
+	// Writes the code lengths of this code to the given bit output stream in a compact format, in the
+	// style of Deflate's dynamic block header. The symbol limit is not written, so the reader must know it.
+	// Every code length must be at most 255. The lengths in symbol order are run-length encoded
+	// as a sequence of meta-symbols, each possibly followed by extra bits (big-endian):
+	// - 0 to 15: a code length of that value.
+	// - 16: a code length of 16 to 255, given by 8 extra bits.
+	// - 17: the previous code length repeated 3 to 6 more times, given by 2 extra bits (plus 3).
+	// - 18: a code length of 0 repeated 3 to 10 times, given by 3 extra bits (plus 3).
+	// - 19: a code length of 0 repeated 11 to 138 times, given by 7 extra bits (plus 11).
+	// The meta-symbols are themselves Huffman-coded with a canonical meta-code of at most 7 bits,
+	// which is optimal for their frequencies, and which comes first in the stream:
+	// - Number of meta-code lengths N, minus 4: 5 bits. N is between 4 and 20.
+	// - The first N meta-code lengths in the order 18, 19, 0, 17, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15, 16,
+	//   which puts the rarest meta-symbols last: 3 bits each. The omitted meta-code lengths are 0.
+	// A code with few used symbols thus takes a few bytes, instead of one byte per symbol.
+	public: void writeCompact(BitOutputStream &out) const;
+	
+	
+	// Reads a code in the format of writeCompact() from the given bit input stream, for the given symbol limit
+	// (which must be the one the code was written with). Throws an exception if the data is malformed.
+	public: static CanonicalCode readCompact(BitInputStream &in, std::uint32_t symbolLimit);
+	
 };
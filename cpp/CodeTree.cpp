@@ -6,6 +6,7 @@
  * https://github.com/nayuki/Reference-Huffman-coding
  */
 
+#include <cstddef>
 #include <stdexcept>
 #include <utility>
 #include "CodeTree.hpp"
@@ -26,37 +27,49 @@ InternalNode::InternalNode(std::unique_ptr<Node> &&left, std::unique_ptr<Node> &
 	rightChild(std::move(right)) {}
 
 
-CodeTree::CodeTree(InternalNode &&rt, uint32_t symbolLimit) :
-		root(std::move(rt)) {
-	if (symbolLimit < 2)
-		throw std::domain_error("At least 2 symbols needed");
-	if (symbolLimit > SIZE_MAX)
-		throw std::length_error("Too many symbols");
-	codes = vector<vector<char> >(symbolLimit, vector<char>());  // Initially all empty
-	vector<char> prefix;
-	buildCodeList(&root, prefix);  // Fill 'codes' with appropriate data
+CodeTree::CodeTree(vector<uint32_t> &&childEntries, uint32_t symbolLimit) :
+		nodes(std::move(childEntries)) {
+	buildCodeList(symbolLimit);
+}
+
+
+CodeTree::CodeTree(InternalNode &&rt, uint32_t symbolLimit) {
+	flattenNodes(&rt);
+	buildCodeList(symbolLimit);
+}
+
+
+const vector<char> &CodeTree::getCode(uint32_t symbol) const {
+	if (codes.at(symbol).empty())
+		throw std::domain_error("No code for given symbol");
+	else
+		return codes.at(symbol);
 }
 
 
-void CodeTree::buildCodeList(const Node *node, vector<char> &prefix) {
+InternalNode CodeTree::toNodeTree() const {
+	uint32_t root = getRoot();
+	return InternalNode(buildNodes(getChild(root, 0)), buildNodes(getChild(root, 1)));
+}
+
+
+uint32_t CodeTree::flattenNodes(const Node *node) {
 	if (dynamic_cast<const InternalNode*>(node) != nullptr) {
 		const InternalNode *internalNode = dynamic_cast<const InternalNode*>(node);
-		
-		prefix.push_back(0);
-		buildCodeList(internalNode->leftChild .get(), prefix);
-		prefix.pop_back();
-		
-		prefix.push_back(1);
-		buildCodeList(internalNode->rightChild.get(), prefix);
-		prefix.pop_back();
+		uint32_t left  = flattenNodes(internalNode->leftChild .get());
+		uint32_t right = flattenNodes(internalNode->rightChild.get());
+		// Children are appended before their parent, so they get lower indexes
+		nodes.push_back(left);
+		nodes.push_back(right);
+		if (nodes.size() / 2 > LEAF_FLAG)
+			throw std::length_error("Too many nodes");
+		return static_cast<uint32_t>(nodes.size() / 2 - 1);
 		
 	} else if (dynamic_cast<const Leaf*>(node) != nullptr) {
-		const Leaf *leaf = dynamic_cast<const Leaf*>(node);
-		if (leaf->symbol >= codes.size())
+		uint32_t symbol = dynamic_cast<const Leaf*>(node)->symbol;
+		if (symbol >= LEAF_FLAG)
 			throw std::invalid_argument("Symbol exceeds symbol limit");
-		if (!codes.at(leaf->symbol).empty())
-			throw std::invalid_argument("Symbol has more than one code");
-		codes.at(leaf->symbol) = prefix;
+		return symbol | LEAF_FLAG;
 		
 	} else {
 		throw std::logic_error("Assertion error: Illegal node type");
@@ -64,9 +77,63 @@ void CodeTree::buildCodeList(const Node *node, vector<char> &prefix) {
 }
 
 
-const vector<char> &CodeTree::getCode(uint32_t symbol) const {
-	if (codes.at(symbol).empty())
-		throw std::domain_error("No code for given symbol");
-	else
-		return codes.at(symbol);
+std::unique_ptr<Node> CodeTree::buildNodes(uint32_t entry) const {
+	if (isLeaf(entry))
+		return std::unique_ptr<Node>(new Leaf(getSymbol(entry)));
+	else {
+		return std::unique_ptr<Node>(new InternalNode(
+			buildNodes(getChild(entry, 0)), buildNodes(getChild(entry, 1))));
+	}
+}
+
+
+void CodeTree::buildCodeList(uint32_t symbolLimit) {
+	if (symbolLimit < 2)
+		throw std::domain_error("At least 2 symbols needed");
+	if (symbolLimit > SIZE_MAX || symbolLimit > LEAF_FLAG)
+		throw std::length_error("Too many symbols");
+	
+	// Check that every internal node except the root has exactly one parent, which has a higher
+	// index. Then every node is reachable from the root, and every path from the root is finite.
+	if (nodes.size() < 2 || nodes.size() % 2 != 0 || nodes.size() / 2 > LEAF_FLAG)
+		throw std::invalid_argument("Invalid number of child entries");
+	std::size_t numInternal = nodes.size() / 2;
+	vector<bool> hasParent(numInternal, false);
+	for (std::size_t i = 0; i < nodes.size(); i++) {
+		uint32_t entry = nodes[i];
+		if (isLeaf(entry))
+			continue;
+		if (entry >= i / 2)
+			throw std::invalid_argument("Child index not less than parent index");
+		if (hasParent.at(entry))
+			throw std::invalid_argument("Node has more than one parent");
+		hasParent.at(entry) = true;
+	}
+	for (std::size_t i = 0; i + 1 < numInternal; i++) {
+		if (!hasParent.at(i))
+			throw std::invalid_argument("Node not reachable from root");
+	}
+	
+	codes = vector<vector<char> >(symbolLimit, vector<char>());  // Initially all empty
+	vector<char> prefix;
+	buildCodeList(getRoot(), prefix);  // Fill 'codes' with appropriate data
+}
+
+
+void CodeTree::buildCodeList(uint32_t node, vector<char> &prefix) {
+	for (int bit = 0; bit < 2; bit++) {
+		uint32_t entry = getChild(node, bit);
+		prefix.push_back(static_cast<char>(bit));
+		if (!isLeaf(entry))
+			buildCodeList(entry, prefix);
+		else {
+			uint32_t symbol = getSymbol(entry);
+			if (symbol >= codes.size())
+				throw std::invalid_argument("Symbol exceeds symbol limit");
+			if (!codes.at(symbol).empty())
+				throw std::invalid_argument("Symbol has more than one code");
+			codes.at(symbol) = prefix;
+		}
+		prefix.pop_back();
+	}
 }
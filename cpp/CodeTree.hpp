@@ -8,13 +8,16 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
 
 
 /* 
- * A node in a code tree. This class has exactly two subclasses: InternalNode, Leaf.
+ * A node in a code tree, as a graph of separately allocated objects. This class has exactly two subclasses:
+ * InternalNode, Leaf. CodeTree itself uses a flat array instead; these classes remain so that trees can
+ * still be built from nodes (see the CodeTree constructor) and converted back (see CodeTree::toNodeTree()).
  */
 class Node {
 	
@@ -57,7 +60,8 @@ class InternalNode final : public Node {
 /* 
  * A binary tree that represents a mapping between symbols and binary strings.
  * The data structure is immutable. There are two main uses of a code tree:
- * - Read the root field and walk through the tree to extract the desired information.
+ * - Start at getRoot() and call getChild() to walk through the tree to extract the desired information.
+ *   (Code written for the older node API can instead call toNodeTree(), which builds a copy of the tree as nodes.)
  * - Call getCode() to get the binary code for a particular encodable symbol.
  * The path to a leaf node determines the leaf's symbol's code. Starting from the root, going
  * to the left child represents a 0, and going to the right child represents a 1. Constraints:
@@ -79,12 +83,25 @@ class InternalNode final : public Node {
  *       B   .
  *          / \
  *         C   D
+ * The tree is stored as one array of 32-bit entries, two per internal node (its left and right child),
+ * so a walk needs no pointer chasing between separate allocations and no run-time type checks. A child
+ * entry with LEAF_FLAG set is a leaf, whose symbol is in the other bits; otherwise it is the index of an
+ * internal node. Every child has a lower index than its parent, so the root is the last internal node.
+ * The example above is stored as [C, D, B, 0, A, 1], where letters stand for leaf entries.
  */
 class CodeTree final {
 	
+	/*---- Constants ----*/
+	
+	// The bit that marks a child entry as a leaf. Thus symbol values must be less than this.
+	public: static const std::uint32_t LEAF_FLAG = UINT32_C(1) << 31;
+	
+	
 	/*---- Fields ----*/
 	
-	public: InternalNode root;
+	// The child entries of the internal nodes: nodes[2*i] is the left child of
+	// internal node i, and nodes[2*i+1] is its right child. Length at least 2.
+	private: std::vector<std::uint32_t> nodes;
 	
 	
 	// Stores the code for each symbol, or null if the symbol has no code.
@@ -92,20 +109,67 @@ class CodeTree final {
 	private: std::vector<std::vector<char> > codes;
 	
 	
-	/*---- Constructor ----*/
+	/*---- Constructors ----*/
 	
-	// Constructs a code tree from the given tree of nodes and given symbol limit.
-	// Each symbol in the tree must have value strictly less than the symbol limit.
+	// Constructs a code tree from the given array of child entries, in the layout described above, and given
+	// symbol limit. Each symbol in the tree must have value strictly less than the symbol limit. Each internal
+	// node other than the root must be the child of exactly one node, which has a higher index.
+	public: explicit CodeTree(std::vector<std::uint32_t> &&childEntries, std::uint32_t symbolLimit);
+	
+	
+	// Constructs a code tree from the given tree of nodes (which is copied into the flat array, not kept) and given
+	// symbol limit. Each symbol in the tree must have value strictly less than the symbol limit.
 	public: explicit CodeTree(InternalNode &&rt, std::uint32_t symbolLimit);
 	
 	
 	/*---- Methods ----*/
 	
-	// Recursive helper function for the constructor
-	private: void buildCodeList(const Node *node, std::vector<char> &prefix);
+	// Returns the index of the root node.
+	public: std::uint32_t getRoot() const {
+		return static_cast<std::uint32_t>(nodes.size() / 2 - 1);
+	}
+	
+	
+	// Returns the left (bit = 0) or right (bit = 1) child entry of the given internal node.
+	public: std::uint32_t getChild(std::uint32_t node, int bit) const {
+		return nodes[static_cast<std::size_t>(node) * 2 + static_cast<unsigned int>(bit)];
+	}
+	
+	
+	// Tests whether the given child entry is a leaf.
+	public: static bool isLeaf(std::uint32_t entry) {
+		return (entry & LEAF_FLAG) != 0;
+	}
+	
+	
+	// Returns the symbol of the given leaf entry.
+	public: static std::uint32_t getSymbol(std::uint32_t entry) {
+		return entry & ~LEAF_FLAG;
+	}
 	
 	
 	// Returns the Huffman code for the given symbol, which is a list of 0s and 1s.
 	public: const std::vector<char> &getCode(std::uint32_t symbol) const;
 	
+	
+	// Returns a newly allocated graph of nodes equivalent to this tree, for code that walks trees of nodes.
+	// Nothing else builds nodes, so a tree that is only walked through getChild() allocates none.
+	public: InternalNode toNodeTree() const;
+	
+	
+	// Recursive helper function for the constructor, which checks and flattens a tree of nodes.
+	private: std::uint32_t flattenNodes(const Node *node);
+	
+	
+	// Recursive helper function for toNodeTree().
+	private: std::unique_ptr<Node> buildNodes(std::uint32_t entry) const;
+	
+	
+	// Helper function for the constructors, which checks the tree structure and fills in the codes.
+	private: void buildCodeList(std::uint32_t symbolLimit);
+	
+	
+	// Recursive helper function for buildCodeList().
+	private: void buildCodeList(std::uint32_t node, std::vector<char> &prefix);
+	
 };
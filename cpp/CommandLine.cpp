@@ -0,0 +1,73 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "CommandLine.hpp"
+
+using std::uint32_t;
+using std::uint64_t;
+
+
+bool CommandLine::parseIntOption(const char *arg, const char *prefix, long minVal, long maxVal, int &result) {
+	std::size_t prefixLen = std::strlen(prefix);
+	if (std::strncmp(arg, prefix, prefixLen) != 0 || arg[prefixLen] == '\0')
+		return false;
+	char *end;
+	long val = std::strtol(arg + prefixLen, &end, 10);
+	if (*end != '\0' || val < minVal || val > maxVal)
+		return false;
+	result = static_cast<int>(val);
+	return true;
+}
+
+
+bool CommandLine::parseUint32Option(const char *arg, const char *prefix, uint32_t minVal, uint32_t &result) {
+	uint64_t val;
+	if (!parseUint64Option(arg, prefix, val) || val < minVal || val > UINT32_MAX)
+		return false;
+	result = static_cast<uint32_t>(val);
+	return true;
+}
+
+
+bool CommandLine::parseUint64Option(const char *arg, const char *prefix, uint64_t &result) {
+	std::size_t prefixLen = std::strlen(prefix);
+	if (std::strncmp(arg, prefix, prefixLen) != 0 || arg[prefixLen] < '0' || arg[prefixLen] > '9')
+		return false;
+	char *end;
+	errno = 0;
+	unsigned long long val = std::strtoull(arg + prefixLen, &end, 10);
+	if (*end != '\0' || errno != 0)
+		return false;
+	result = static_cast<uint64_t>(val);
+	return true;
+}
+
+
+std::streambuf *CommandLine::openInput(const char *path, std::filebuf &file) {
+	if (std::strcmp(path, "-") == 0)
+		return std::cin.rdbuf();
+	if (file.open(path, std::ios::in | std::ios::binary) == nullptr)
+		throw std::runtime_error(std::string("Cannot open ") + path);
+	return &file;
+}
+
+
+std::streambuf *CommandLine::openOutput(const char *path, std::filebuf &file) {
+	if (std::strcmp(path, "-") == 0)
+		return std::cout.rdbuf();
+	if (file.open(path, std::ios::out | std::ios::trunc | std::ios::binary) == nullptr)
+		throw std::runtime_error(std::string("Cannot open ") + path);
+	return &file;
+}
@@ -0,0 +1,50 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <streambuf>
+
+
+/* 
+ * Helpers shared by the command line applications, for parsing options of the form --name=value
+ * and for opening the files named by arguments, where "-" means standard input or output.
+ */
+class CommandLine final {
+	
+	/*---- Option parsing ----*/
+	
+	// If the given argument is the given prefix followed by an integer in the given range,
+	// then stores the integer in result and returns true. Otherwise returns false.
+	public: static bool parseIntOption(const char *arg, const char *prefix, long minVal, long maxVal, int &result);
+	
+	
+	// If the given argument is the given prefix followed by an unsigned 32-bit integer of at least the given
+	// minimum, then stores the integer in result and returns true. Otherwise returns false.
+	public: static bool parseUint32Option(const char *arg, const char *prefix, std::uint32_t minVal, std::uint32_t &result);
+	
+	
+	// If the given argument is the given prefix followed by a non-negative
+	// integer, then stores it in result and returns true. Otherwise returns false.
+	public: static bool parseUint64Option(const char *arg, const char *prefix, std::uint64_t &result);
+	
+	
+	/*---- File opening ----*/
+	
+	// Opens the given file for reading in the given buffer and returns it, or returns standard input's buffer
+	// if the path is "-". Throws runtime_error if the file cannot be opened.
+	public: static std::streambuf *openInput(const char *path, std::filebuf &file);
+	
+	
+	// Opens the given file for writing in the given buffer and returns it, or returns standard output's buffer
+	// if the path is "-". Throws runtime_error if the file cannot be opened.
+	public: static std::streambuf *openOutput(const char *path, std::filebuf &file);
+	
+};
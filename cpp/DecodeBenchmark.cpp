@@ -0,0 +1,145 @@
+/* 
+ * Benchmark of the table-driven Huffman decoders
+ * 
+ * Usage: DecodeBenchmark [InputFile]
+ * Compresses the given file in memory with static Huffman coding (or, if no file is given,
+ * generated text with a skewed symbol distribution), then decodes it repeatedly with
+ * DecodeTable (one symbol per lookup) and MultiDecodeTable (several symbols per lookup).
+ * The best time of each decoder is reported as throughput of decompressed bytes.
+ * The default build flags enable a sanitizer, so for meaningful numbers build with
+ * optimization only, for example: make CXXFLAGS="-std=c++11 -O2" DecodeBenchmark
+ * 
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "BitIoStream.hpp"
+#include "CanonicalCode.hpp"
+#include "DecodeTable.hpp"
+#include "EncodeTable.hpp"
+#include "FrequencyTable.hpp"
+
+using std::uint8_t;
+using std::uint32_t;
+using std::vector;
+
+
+static const int NUM_TRIALS = 5;
+
+static vector<uint8_t> generateSkewedData(std::size_t length);
+static double timeDecoder(const std::string &compressed, const vector<uint8_t> &expected, const CanonicalCode &canonCode, bool multiSymbol);
+
+
+int main(int argc, char *argv[]) {
+	// Handle command line arguments
+	if (argc > 2) {
+		std::cerr << "Usage: " << argv[0] << " [InputFile]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	vector<uint8_t> data;
+	if (argc == 2) {
+		std::ifstream in(argv[1], std::ios::binary);
+		if (!in) {
+			std::cerr << "Cannot open " << argv[1] << std::endl;
+			return EXIT_FAILURE;
+		}
+		data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	} else
+		data = generateSkewedData(UINT32_C(1) << 24);
+	
+	// Compress the data in memory, without a header
+	FrequencyTable freqs(vector<uint32_t>(257, 0));
+	freqs.incrementBytes(data.data(), data.size());
+	freqs.increment(256);  // EOF symbol gets a frequency of 1
+	const CanonicalCode canonCode(freqs.buildCodeTree(), freqs.getSymbolLimit());
+	const EncodeTable table(canonCode);
+	std::ostringstream out;
+	BitOutputStream bout(out);
+	for (uint8_t b : data)
+		table.write(bout, b);
+	table.write(bout, 256);  // EOF
+	bout.finish();
+	const std::string compressed = out.str();
+	std::cout << "Input: " << data.size() << " bytes, compressed: " << compressed.size() << " bytes" << std::endl;
+	
+	// Time each decoder
+	double megabytes = data.size() / 1.0e6;
+	double singleTime = timeDecoder(compressed, data, canonCode, false);
+	std::cout << "Single-symbol decoding: " << megabytes / singleTime << " MB/s" << std::endl;
+	double multiTime = timeDecoder(compressed, data, canonCode, true);
+	std::cout << "Multi-symbol decoding:  " << megabytes / multiTime << " MB/s" << std::endl;
+	return EXIT_SUCCESS;
+}
+
+
+// Returns text-like data where a few symbols are very common and most are rare (Zipf distribution).
+static vector<uint8_t> generateSkewedData(std::size_t length) {
+	vector<double> weights;
+	for (int i = 0; i < 64; i++)
+		weights.push_back(1.0 / (i + 1));
+	std::mt19937 rng(1);
+	std::discrete_distribution<int> dist(weights.begin(), weights.end());
+	vector<uint8_t> result;
+	for (std::size_t i = 0; i < length; i++)
+		result.push_back(static_cast<uint8_t>(' ' + dist(rng)));
+	return result;
+}
+
+
+// Decodes the given compressed data several times and returns the best time in seconds.
+static double timeDecoder(const std::string &compressed, const vector<uint8_t> &expected, const CanonicalCode &canonCode, bool multiSymbol) {
+	double bestTime = 1.0e30;
+	for (int trial = 0; trial < NUM_TRIALS; trial++) {
+		vector<uint8_t> result(expected.size() + MultiDecodeTable::MAX_SYMBOLS_PER_ENTRY);
+		uint8_t *p = result.data();
+		std::istringstream in(compressed);
+		auto start = std::chrono::steady_clock::now();
+		
+		BitInputStream bin(in);
+		if (multiSymbol) {
+			const MultiDecodeTable table(canonCode, MultiDecodeTable::DEFAULT_TABLE_BITS, 256);
+			uint32_t symbols[MultiDecodeTable::MAX_SYMBOLS_PER_ENTRY];
+			while (true) {
+				int n = table.read(bin, symbols);
+				// Store all entry slots unconditionally, then advance by the number of valid ones
+				for (int i = 0; i < MultiDecodeTable::MAX_SYMBOLS_PER_ENTRY; i++)
+					p[i] = static_cast<uint8_t>(symbols[i]);
+				if (symbols[n - 1] == 256) {
+					p += n - 1;
+					break;
+				}
+				p += n;
+			}
+		} else {
+			const DecodeTable table(canonCode, DecodeTable::DEFAULT_TABLE_BITS);
+			while (true) {
+				uint32_t symbol = table.read(bin);
+				if (symbol == 256)
+					break;
+				*p = static_cast<uint8_t>(symbol);
+				p++;
+			}
+		}
+		
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		result.resize(static_cast<std::size_t>(p - result.data()));
+		if (result != expected)
+			throw std::logic_error("Assertion error: Decoded data mismatch");
+		bestTime = std::min(elapsed.count(), bestTime);
+	}
+	return bestTime;
+}
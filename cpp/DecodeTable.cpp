@@ -0,0 +1,111 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include "DecodeTable.hpp"
+
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+
+DecodeTable::DecodeTable(const CanonicalCode &code, int maxTableBits) {
+	if (maxTableBits < 1 || maxTableBits > MAX_TABLE_BITS)
+		throw std::domain_error("Table bits out of range");
+	uint32_t symbolLimit = code.getSymbolLimit();
+	if (symbolLimit > (UINT32_C(1) << 24))
+		throw std::length_error("Too many symbols");
+	
+	// Sort the symbols into canonical order, and copy the number of codes of each length
+	uint32_t maxCodeLength = code.getMaxCodeLength();
+	numCodesOfLength = vector<uint32_t>(maxCodeLength + 1, 0);
+	for (uint32_t i = 1; i <= maxCodeLength; i++)
+		numCodesOfLength[i] = code.getNumCodesOfLength(i);
+	sortedSymbols = code.getSymbolsInCodeOrder();
+	
+	// Fill the table by assigning code values in canonical order
+	tableBits = static_cast<int>(std::min(static_cast<uint32_t>(maxTableBits), maxCodeLength));
+	table = vector<uint32_t>(static_cast<std::size_t>(1) << tableBits, 0);
+	uint64_t nextCode = 0;
+	uint32_t codeLength = 0;
+	firstCodeOfTableLength = 0;
+	firstIndexOfTableLength = 0;
+	for (uint32_t i = 0; i < sortedSymbols.size(); i++) {
+		uint32_t symbol = sortedSymbols.at(i);
+		uint32_t len = code.getCodeLength(symbol);
+		if (len > static_cast<uint32_t>(tableBits))
+			break;
+		nextCode <<= len - codeLength;
+		codeLength = len;
+		std::size_t shift = static_cast<std::size_t>(tableBits) - len;
+		std::fill(table.begin() + static_cast<std::ptrdiff_t>(nextCode << shift),
+			table.begin() + static_cast<std::ptrdiff_t>((nextCode + 1) << shift), (symbol << 8) | len);
+		nextCode++;
+	}
+	
+	// Compute where the codes of length tableBits start, for continuing long codes
+	for (int i = 1; i <= tableBits; i++) {
+		firstCodeOfTableLength = (firstCodeOfTableLength + numCodesOfLength.at(i - 1)) << 1;
+		firstIndexOfTableLength += numCodesOfLength.at(i - 1);
+	}
+}
+
+
+uint32_t DecodeTable::readLongCode(BitInputStream &in) const {
+	// Invariant: diff is the current code value minus the first code value of the current length,
+	// and index is the position in sortedSymbols of the first symbol with the current length.
+	// Because shorter codes are lexicographically lower, diff never goes negative.
+	uint64_t diff = in.readBits(tableBits) - firstCodeOfTableLength;
+	uint32_t index = firstIndexOfTableLength;
+	for (std::size_t len = static_cast<std::size_t>(tableBits); ; ) {
+		diff -= numCodesOfLength[len];
+		index += numCodesOfLength[len];
+		len++;
+		if (len >= numCodesOfLength.size())
+			throw std::logic_error("Assertion error: Code not found");
+		diff = (diff << 1) | static_cast<uint64_t>(in.readNoEof());
+		if (diff < numCodesOfLength[len])
+			return sortedSymbols[index + diff];
+	}
+}
+
+
+MultiDecodeTable::MultiDecodeTable(const CanonicalCode &code, int maxTableBits, uint32_t stopSymbol) :
+		singleTable(code, maxTableBits) {
+	if (code.getSymbolLimit() > (UINT32_C(1) << 16))
+		throw std::length_error("Too many symbols");
+	
+	// For each window, greedily take whole codes from its start using the single-symbol table
+	int tableBits = singleTable.tableBits;
+	uint32_t mask = (UINT32_C(1) << tableBits) - 1;
+	table = vector<Entry>(singleTable.table.size());
+	for (uint32_t i = 0; i < table.size(); i++) {
+		Entry &entry = table.at(i);
+		entry = Entry();
+		int numBits = 0;
+		while (entry.numSymbols < MAX_SYMBOLS_PER_ENTRY) {
+			uint32_t single = singleTable.table.at((i << numBits) & mask);
+			int len = static_cast<int>(single & 0xFF);
+			if (single == 0 || numBits + len > tableBits)
+				break;
+			uint32_t symbol = single >> 8;
+			entry.symbols[entry.numSymbols] = static_cast<std::uint16_t>(symbol);
+			entry.numSymbols++;
+			numBits += len;
+			if (symbol == stopSymbol)
+				break;
+		}
+		entry.numBits = static_cast<std::uint8_t>(numBits);
+	}
+}
+
+
+const DecodeTable &MultiDecodeTable::getSingleTable() const {
+	return singleTable;
+}
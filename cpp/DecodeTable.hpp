@@ -0,0 +1,170 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BitIoStream.hpp"
+#include "CanonicalCode.hpp"
+
+
+/* 
+ * A lookup table for decoding symbols of a canonical Huffman code. Immutable.
+ * The table is indexed by the next tableBits bits of the stream. Each entry whose window
+ * starts with a code of length at most tableBits gives that symbol and its code length,
+ * so decoding it takes one peek, one table load and one consume. Windows that start
+ * with a longer code fall back to extending the code one bit at a time, using the
+ * canonical property that all codes of the same length are consecutive integers.
+ * For example with tableBits = 2 and the codes A = 0, D = 10, B = 110, E = 111:
+ *   Window 00: Symbol A, length 1
+ *   Window 01: Symbol A, length 1
+ *   Window 10: Symbol D, length 2
+ *   Window 11: Long code, continue with the next bit
+ */
+class DecodeTable final {
+	
+	/*---- Constants ----*/
+	
+	// A good default for the number of table index bits, which keeps the table in the L1 cache.
+	public: static const int DEFAULT_TABLE_BITS = 11;
+	
+	// The maximum number of table index bits accepted by the constructor.
+	public: static const int MAX_TABLE_BITS = 20;
+	
+	
+	/*---- Fields ----*/
+	
+	// The number of bits used to index the table, between 1 and MAX_TABLE_BITS.
+	// This is the smaller of the requested number and the longest code length.
+	private: int tableBits;
+	
+	// For each window of tableBits bits, (symbol << 8) | codeLength if the window
+	// starts with a code of length at most tableBits, or 0 if it starts with a longer code.
+	private: std::vector<std::uint32_t> table;
+	
+	// All symbols that have a code, sorted by ascending code length and then by ascending symbol value.
+	// This is also the order of ascending code values.
+	private: std::vector<std::uint32_t> sortedSymbols;
+	
+	// numCodesOfLength[i] is the number of symbols with code length i. Its size is the longest code length plus 1.
+	private: std::vector<std::uint32_t> numCodesOfLength;
+	
+	// The value of the first code of length tableBits, and the index of its symbol in sortedSymbols.
+	private: std::uint64_t firstCodeOfTableLength;
+	private: std::uint32_t firstIndexOfTableLength;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Builds a decoding table for the given canonical code, indexed by at most the given number of bits.
+	// The number of table bits must be between 1 and MAX_TABLE_BITS, and the code's symbol limit must be at most 2^24.
+	public: explicit DecodeTable(const CanonicalCode &code, int maxTableBits);
+	
+	
+	/*---- Methods ----*/
+	
+	// Reads from the given bit input stream to decode the next Huffman-coded symbol.
+	public: std::uint32_t read(BitInputStream &in) const;
+	
+	
+	// Slow path of read(), for a window that starts with a code longer than tableBits.
+	private: std::uint32_t readLongCode(BitInputStream &in) const;
+	
+	
+	friend class MultiDecodeTable;
+	
+};
+
+
+
+/* 
+ * A lookup table for decoding several symbols of a canonical Huffman code at once. Immutable.
+ * Like DecodeTable, the table is indexed by the next tableBits bits of the stream, but each
+ * entry holds as many whole codes (up to MAX_SYMBOLS_PER_ENTRY) as fit in the window. This pays
+ * off for skewed data, where short codes are common. For example with tableBits = 3 and the
+ * codes A = 0, D = 10, B = 110, E = 111, the window 010 decodes to the symbols A, D.
+ * Entries never continue past the stop symbol, so that a stream that ends with an EOF symbol
+ * is not read beyond its end. Windows that start with a code longer than tableBits are
+ * handled by the same slow path as DecodeTable.
+ */
+class MultiDecodeTable final {
+	
+	/*---- Constants ----*/
+	
+	// The maximum number of symbols that one table entry can decode.
+	public: static const int MAX_SYMBOLS_PER_ENTRY = 3;
+	
+	// A good default for the number of table index bits, which keeps the table in the L1 cache.
+	public: static const int DEFAULT_TABLE_BITS = 12;
+	
+	
+	/*---- Fields ----*/
+	
+	// The table for decoding one symbol at a time, used to build this table and for long codes.
+	private: DecodeTable singleTable;
+	
+	// Helper structure for the table below.
+	private: struct Entry {
+		std::uint16_t symbols[MAX_SYMBOLS_PER_ENTRY];
+		std::uint8_t numSymbols;  // 0 if the window starts with a code longer than tableBits
+		std::uint8_t numBits;  // Total code length of the decoded symbols
+	};
+	
+	// For each window of singleTable.tableBits bits, the symbols of the whole codes at its start.
+	private: std::vector<Entry> table;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Builds a multi-symbol decoding table for the given canonical code, indexed by at most the
+	// given number of bits. The number of table bits must be between 1 and DecodeTable::MAX_TABLE_BITS,
+	// and the code's symbol limit must be at most 2^16. No entry decodes any symbol after the
+	// given stop symbol; use a value not less than the symbol limit if there is no such symbol.
+	public: explicit MultiDecodeTable(const CanonicalCode &code, int maxTableBits, std::uint32_t stopSymbol);
+	
+	
+	/*---- Methods ----*/
+	
+	// Returns the table for decoding one symbol at a time, for the same code. This is
+	// useful near the end of a stream whose symbol count is known, where an entry
+	// could otherwise decode symbols from the padding after the last code.
+	public: const DecodeTable &getSingleTable() const;
+	
+	
+	// Reads from the given bit input stream to decode the next one or more Huffman-coded symbols.
+	// Stores them at the start of the given array, which must have room for MAX_SYMBOLS_PER_ENTRY
+	// elements, and returns the number of symbols decoded (between 1 and MAX_SYMBOLS_PER_ENTRY).
+	public: int read(BitInputStream &in, std::uint32_t symbols[]) const;
+	
+};
+
+
+
+// Inline definition, because this method is called once per decoded symbol.
+inline std::uint32_t DecodeTable::read(BitInputStream &in) const {
+	std::uint32_t entry = table[static_cast<std::size_t>(in.peekBits(tableBits))];
+	if (entry == 0)
+		return readLongCode(in);
+	in.consumeBits(static_cast<int>(entry & 0xFF));
+	return entry >> 8;
+}
+
+
+inline int MultiDecodeTable::read(BitInputStream &in, std::uint32_t symbols[]) const {
+	const Entry &entry = table[static_cast<std::size_t>(in.peekBits(singleTable.tableBits))];
+	if (entry.numSymbols == 0) {
+		symbols[0] = singleTable.readLongCode(in);
+		return 1;
+	}
+	in.consumeBits(entry.numBits);
+	for (int i = 0; i < MAX_SYMBOLS_PER_ENTRY; i++)
+		symbols[i] = entry.symbols[i];
+	return entry.numSymbols;
+}
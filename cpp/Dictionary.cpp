@@ -0,0 +1,120 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "Dictionary.hpp"
+#include "FramedFormat.hpp"
+
+using std::uint8_t;
+using std::uint32_t;
+
+
+const uint8_t Dictionary::MAGIC[MAGIC_SIZE] = {0x48, 0x44, 0x49, 0x43};
+
+
+Dictionary::Dictionary(uint32_t id, const CanonicalCode &code) :
+		id(id),
+		code(code),
+		encodeTable(code),
+		decodeTable(code, DecodeTable::DEFAULT_TABLE_BITS),
+		multiDecodeTable(code, MultiDecodeTable::DEFAULT_TABLE_BITS, EOF_SYMBOL) {
+	if (!isComplete(code))
+		throw std::domain_error("Dictionary code must cover every symbol");
+}
+
+
+CanonicalCode Dictionary::train(const FrequencyTable &freqs, uint32_t maxCodeLength) {
+	if (freqs.getSymbolLimit() != SYMBOL_LIMIT)
+		throw std::domain_error("Invalid symbol limit");
+	if (maxCodeLength < MIN_CODE_LENGTH || maxCodeLength > FramedFormat::MAX_CODE_LENGTH)
+		throw std::domain_error("Maximum code length out of range");
+	FrequencyTable smoothed(freqs);
+	for (uint32_t i = 0; i < SYMBOL_LIMIT; i++)
+		smoothed.set(i, std::max(freqs.get(i), static_cast<std::uint64_t>(1)));
+	return CanonicalCode(smoothed.buildCodeLengths(maxCodeLength));
+}
+
+
+uint32_t Dictionary::defaultId(const CanonicalCode &code) {
+	uint32_t hash = UINT32_C(0x811C9DC5);
+	for (uint32_t i = 0; i < code.getSymbolLimit(); i++) {
+		hash ^= code.getCodeLength(i);
+		hash *= UINT32_C(0x01000193);
+	}
+	return hash;
+}
+
+
+Dictionary Dictionary::read(std::istream &in) {
+	uint8_t header[MAGIC_SIZE + 4];
+	in.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (static_cast<std::size_t>(in.gcount()) != sizeof(header))
+		throw std::runtime_error("Unexpected end of file");
+	if (!std::equal(MAGIC, MAGIC + MAGIC_SIZE, header))
+		throw std::runtime_error("Invalid magic number");
+	BitInputStream bin(in);
+	const CanonicalCode code = CanonicalCode::readCompact(bin, SYMBOL_LIMIT);
+	if (!isComplete(code))
+		throw std::runtime_error("Dictionary code does not cover every symbol");
+	return Dictionary(FramedFormat::readUint32(&header[MAGIC_SIZE]), code);
+}
+
+
+uint32_t Dictionary::getId() const {
+	return id;
+}
+
+
+const CanonicalCode &Dictionary::getCode() const {
+	return code;
+}
+
+
+const EncodeTable &Dictionary::getEncodeTable() const {
+	return encodeTable;
+}
+
+
+const DecodeTable &Dictionary::getDecodeTable() const {
+	return decodeTable;
+}
+
+
+const MultiDecodeTable &Dictionary::getMultiDecodeTable() const {
+	return multiDecodeTable;
+}
+
+
+void Dictionary::write(std::ostream &out) const {
+	uint8_t header[MAGIC_SIZE + 4];
+	std::copy(MAGIC, MAGIC + MAGIC_SIZE, header);
+	FramedFormat::writeUint32(id, &header[MAGIC_SIZE]);
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+	BitOutputStream bout(out);
+	code.writeCompact(bout);
+	bout.finish();
+}
+
+
+void Dictionary::writeHeader(BitOutputStream &out) const {
+	out.writeBits(MARKER, 8);
+	out.writeBits(id, 32);
+}
+
+
+bool Dictionary::isComplete(const CanonicalCode &code) {
+	if (code.getSymbolLimit() != SYMBOL_LIMIT)
+		return false;
+	for (uint32_t i = 0; i < SYMBOL_LIMIT; i++) {
+		if (code.getCodeLength(i) == 0)
+			return false;
+	}
+	return true;
+}
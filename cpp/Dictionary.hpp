@@ -0,0 +1,125 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include "BitIoStream.hpp"
+#include "CanonicalCode.hpp"
+#include "DecodeTable.hpp"
+#include "EncodeTable.hpp"
+#include "FrequencyTable.hpp"
+
+
+/* 
+ * A pre-trained static code for the plain format's alphabet (256 byte values and the EOF symbol 256), with an ID.
+ * A message compressed with a dictionary has no code length table, which is most of the output for small messages.
+ * It starts with the byte FD, then the dictionary ID (big-endian uint32), then the Huffman-coded bytes and the
+ * EOF symbol, in one bit stream. No file in the plain format starts with the byte FD, because that would mean the
+ * code for symbol 0 is 253 bits long. The decompressor must be given a dictionary with the same ID.
+ * Every symbol has a code, so any message can be compressed, even with bytes that were absent from the samples.
+ * A dictionary file consists of the 4 bytes 48 44 49 43 ("HDIC"), the ID (big-endian uint32),
+ * and then the code lengths in the compact format of CanonicalCode::writeCompact().
+ * Immutable. The encoding and decoding tables are built once by the constructor, so one instance
+ * can be shared read-only by any number of threads compressing or decompressing messages at once.
+ */
+class Dictionary final {
+	
+	/*---- Constants ----*/
+	
+	// The number of bytes in the magic number at the start of a dictionary file.
+	public: static const std::size_t MAGIC_SIZE = 4;
+	
+	// The magic number at the start of a dictionary file.
+	public: static const std::uint8_t MAGIC[MAGIC_SIZE];
+	
+	// The first byte of a message compressed with a dictionary.
+	public: static const int MARKER = 0xFD;
+	
+	// The number of symbols in the alphabet, and the EOF symbol that ends every message.
+	public: static const std::uint32_t SYMBOL_LIMIT = 257;
+	public: static const std::uint32_t EOF_SYMBOL = 256;
+	
+	// The shortest allowed maximum code length for training, because
+	// codes of SYMBOL_LIMIT symbols cannot all be shorter than 9 bits.
+	public: static const std::uint32_t MIN_CODE_LENGTH = 9;
+	
+	// The default maximum code length for training. This bounds the cost of bytes that are
+	// rare or absent in the samples, and lets most symbols decode in a single table lookup.
+	public: static const std::uint32_t DEFAULT_MAX_CODE_LENGTH = 15;
+	
+	
+	/*---- Fields ----*/
+	
+	private: std::uint32_t id;
+	
+	private: CanonicalCode code;
+	
+	private: EncodeTable encodeTable;
+	
+	private: DecodeTable decodeTable;
+	
+	// Decodes several symbols per lookup, stopping at the EOF symbol.
+	private: MultiDecodeTable multiDecodeTable;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Creates a dictionary with the given ID and code, and builds its tables. The code must
+	// have a symbol limit of SYMBOL_LIMIT and a code for every symbol, else domain_error is thrown.
+	public: explicit Dictionary(std::uint32_t id, const CanonicalCode &code);
+	
+	
+	/*---- Static functions ----*/
+	
+	// Returns the optimal code within the given maximum length (between MIN_CODE_LENGTH and 255) for the given byte frequencies
+	// of a sample corpus, which must have a symbol limit of SYMBOL_LIMIT. Each symbol with a frequency of 0 is counted
+	// as 1, so that it still gets a code. The frequency of the EOF symbol should be the number of sample messages.
+	public: static CanonicalCode train(const FrequencyTable &freqs, std::uint32_t maxCodeLength);
+	
+	
+	// Returns an ID derived from the given code lengths (32-bit FNV-1a), so that different codes rarely share an ID.
+	public: static std::uint32_t defaultId(const CanonicalCode &code);
+	
+	
+	// Reads a dictionary file from the given stream. Throws runtime_error if the data is malformed.
+	public: static Dictionary read(std::istream &in);
+	
+	
+	/*---- Methods ----*/
+	
+	public: std::uint32_t getId() const;
+	
+	
+	public: const CanonicalCode &getCode() const;
+	
+	
+	public: const EncodeTable &getEncodeTable() const;
+	
+	
+	public: const DecodeTable &getDecodeTable() const;
+	
+	
+	public: const MultiDecodeTable &getMultiDecodeTable() const;
+	
+	
+	// Writes this dictionary as a dictionary file to the given stream.
+	public: void write(std::ostream &out) const;
+	
+	
+	// Writes the start of a message compressed with this dictionary (the marker and the ID) to the given stream.
+	public: void writeHeader(BitOutputStream &out) const;
+	
+	
+	// Tests whether the given code has the dictionary alphabet and a code for every symbol.
+	private: static bool isComplete(const CanonicalCode &code);
+	
+};
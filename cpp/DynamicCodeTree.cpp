@@ -0,0 +1,140 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include "DynamicCodeTree.hpp"
+
+using std::uint32_t;
+using std::vector;
+
+
+DynamicCodeTree::DynamicCodeTree(uint32_t symbolLimit) {
+	if (symbolLimit < 2)
+		throw std::domain_error("At least 2 symbols needed");
+	if (symbolLimit > MAX_SYMBOL_LIMIT)
+		throw std::domain_error("Too many symbols");
+	build(vector<uint32_t>(symbolLimit, 1));
+}
+
+
+void DynamicCodeTree::write(BitOutputStream &out, uint32_t symbol) const {
+	if (symbol >= leafSlots.size())
+		throw std::domain_error("Symbol out of range");
+	// Collect the bits from the leaf up, so the root's bit ends up as the most significant
+	uint32_t root = static_cast<uint32_t>(weights.size() - 1);
+	std::uint64_t bits = 0;
+	int numBits = 0;
+	for (uint32_t slot = leafSlots[symbol]; slot != root; slot = parents[slot], numBits++)
+		bits |= static_cast<std::uint64_t>(slot & 1) << numBits;
+	out.writeBits(bits, numBits);
+}
+
+
+uint32_t DynamicCodeTree::read(BitInputStream &in) const {
+	// Walk down from the root using a window of the next bits, which is longer than any code
+	std::uint64_t window = in.peekBits(32);
+	int numBits = 0;
+	uint32_t slot = static_cast<uint32_t>(weights.size() - 1);
+	while ((contents[slot] & LEAF_FLAG) == 0) {
+		slot = contents[slot] + static_cast<uint32_t>((window >> (31 - numBits)) & 1);
+		numBits++;
+	}
+	in.consumeBits(numBits);
+	return contents[slot] & ~LEAF_FLAG;
+}
+
+
+void DynamicCodeTree::increment(uint32_t symbol) {
+	if (symbol >= leafSlots.size())
+		throw std::domain_error("Symbol out of range");
+	uint32_t root = static_cast<uint32_t>(weights.size() - 1);
+	for (uint32_t slot = leafSlots[symbol]; slot != root; slot = parents[slot]) {
+		// Move the subtree to the highest slot of the same weight below the root, if that is not its own slot.
+		// The target is never an ancestor, because every ancestor is heavier. Then the increment keeps the order.
+		if (slot + 1 < root && weights[slot + 1] == weights[slot]) {
+			uint32_t leader = static_cast<uint32_t>(std::upper_bound(weights.begin() + slot, weights.end() - 1, weights[slot]) - weights.begin()) - 1;
+			swapSlots(slot, leader);
+			slot = leader;
+		}
+		weights[slot]++;
+	}
+	weights[root]++;
+	
+	if (weights[root] >= MAX_WEIGHT) {
+		vector<uint32_t> counts;
+		for (uint32_t slot : leafSlots)
+			counts.push_back((weights[slot] + 1) / 2);
+		build(counts);
+	}
+}
+
+
+void DynamicCodeTree::build(const vector<uint32_t> &counts) {
+	uint32_t numSymbols = static_cast<uint32_t>(counts.size());
+	uint32_t numSlots = numSymbols * 2 - 1;
+	weights.assign(numSlots, 0);
+	contents.assign(numSlots, 0);
+	parents.assign(numSlots, 0);
+	leafSlots.assign(numSymbols, 0);
+	
+	vector<uint32_t> leaves(numSymbols);
+	std::iota(leaves.begin(), leaves.end(), 0);
+	std::stable_sort(leaves.begin(), leaves.end(), [&counts](uint32_t x, uint32_t y) {
+		return counts[x] < counts[y];
+	});
+	
+	// Merge the two lightest nodes at a time from two queues: the leaves in ascending order, and the
+	// internal nodes in the order they are made, which is also ascending. Each node gets the next slot
+	// when it is taken from a queue, so the slots are in ascending order of weight and siblings are adjacent.
+	vector<uint32_t> internalWeights;
+	vector<uint32_t> internalContents;
+	std::size_t leafIndex = 0;
+	std::size_t internalIndex = 0;
+	for (uint32_t slot = 0; slot < numSlots - 1; ) {
+		uint32_t left = slot;
+		for (int i = 0; i < 2; i++, slot++) {
+			// Take the next leaf or internal node, preferring the leaf on a tie
+			if (leafIndex < leaves.size() && (internalIndex == internalWeights.size()
+					|| counts[leaves[leafIndex]] <= internalWeights[internalIndex])) {
+				uint32_t symbol = leaves[leafIndex];
+				leafIndex++;
+				weights[slot] = counts[symbol];
+				setContent(slot, symbol | LEAF_FLAG);
+			} else {
+				weights[slot] = internalWeights[internalIndex];
+				setContent(slot, internalContents[internalIndex]);
+				internalIndex++;
+			}
+		}
+		internalWeights.push_back(weights[left] + weights[left + 1]);
+		internalContents.push_back(left);
+	}
+	weights[numSlots - 1] = internalWeights.back();
+	setContent(numSlots - 1, internalContents.back());
+}
+
+
+void DynamicCodeTree::swapSlots(uint32_t a, uint32_t b) {
+	uint32_t temp = contents[a];
+	setContent(a, contents[b]);
+	setContent(b, temp);
+}
+
+
+void DynamicCodeTree::setContent(uint32_t slot, uint32_t content) {
+	contents[slot] = content;
+	if ((content & LEAF_FLAG) != 0)
+		leafSlots[content & ~LEAF_FLAG] = slot;
+	else {
+		parents[content] = slot;
+		parents[content + 1] = slot;
+	}
+}
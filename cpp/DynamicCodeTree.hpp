@@ -0,0 +1,94 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "BitIoStream.hpp"
+
+
+/* 
+ * A code tree for one-pass dynamic Huffman coding (algorithm FGK), which stays a Huffman
+ * tree for the symbol counts seen so far by being updated after every symbol. Mutable.
+ * Every symbol starts with a count of 1, so no escape code is needed for new symbols.
+ * The nodes are numbered by slot, from the leaves up to the root in the last slot, and the tree keeps
+ * the sibling property: the weights are in ascending order of slot, and the two children of each
+ * internal node are in adjacent slots (left child in an even slot). Incrementing a symbol walks from
+ * its leaf to the root. At each node it first swaps the node's subtree with the node in the highest
+ * slot of the same weight, which keeps the weights in order after the increment. So an update
+ * takes time proportional to the code length, times a binary search for the swap target.
+ * When the root weight reaches MAX_WEIGHT, all counts are halved (rounding up) and the tree is
+ * rebuilt, which keeps codes short and lets the code adapt to changing statistics.
+ * An encoder and decoder that apply the same updates in the same order have the same tree.
+ */
+class DynamicCodeTree final {
+	
+	/*---- Constants ----*/
+	
+	// The root weight at which all counts are halved. The codes of a Huffman tree with
+	// leaf weights of at least 1 are shorter than 30 bits as long as the root weight is below 2^20.
+	public: static const std::uint32_t MAX_WEIGHT = UINT32_C(1) << 18;
+	
+	// The largest number of symbols. Halving rounds counts up, so the root weight is at least the number of
+	// symbols after halving. Up to half of MAX_WEIGHT, halving leaves at most 3/4 of MAX_WEIGHT, so at least
+	// MAX_WEIGHT/4 updates happen between halvings instead of the tree being rebuilt on every update.
+	public: static const std::uint32_t MAX_SYMBOL_LIMIT = MAX_WEIGHT / 2;
+	
+	// The bit that marks a slot as a leaf, as in CodeTree.
+	private: static const std::uint32_t LEAF_FLAG = UINT32_C(1) << 31;
+	
+	
+	/*---- Fields ----*/
+	
+	// For each slot, the weight of its node, which is the sum of the counts of the leaves below it.
+	private: std::vector<std::uint32_t> weights;
+	
+	// For each slot, the symbol with LEAF_FLAG set if it holds a leaf, otherwise the slot of its left child.
+	private: std::vector<std::uint32_t> contents;
+	
+	// For each slot except the root, the slot of its parent.
+	private: std::vector<std::uint32_t> parents;
+	
+	// For each symbol, the slot of its leaf.
+	private: std::vector<std::uint32_t> leafSlots;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Constructs a tree for the given number of symbols (between 2 and MAX_SYMBOL_LIMIT), each with a count of 1.
+	public: explicit DynamicCodeTree(std::uint32_t symbolLimit);
+	
+	
+	/*---- Methods ----*/
+	
+	// Writes the current code of the given symbol to the given stream.
+	public: void write(BitOutputStream &out, std::uint32_t symbol) const;
+	
+	
+	// Reads from the given stream to decode the next symbol with the current code.
+	public: std::uint32_t read(BitInputStream &in) const;
+	
+	
+	// Increments the count of the given symbol and updates the tree.
+	public: void increment(std::uint32_t symbol);
+	
+	
+	// Rebuilds the tree as a Huffman tree for the given counts, numbering the nodes in the order that the
+	// Huffman algorithm merges them, which gives the sibling property. Ties are broken by symbol value.
+	private: void build(const std::vector<std::uint32_t> &counts);
+	
+	
+	// Exchanges the subtrees in the given two slots, which must have the same weight.
+	private: void swapSlots(std::uint32_t a, std::uint32_t b);
+	
+	
+	// Stores the given leaf or internal node content in the given slot, and links the leaf or children to the slot.
+	private: void setContent(std::uint32_t slot, std::uint32_t content);
+	
+};
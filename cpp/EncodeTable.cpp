@@ -0,0 +1,74 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <algorithm>
+#include "EncodeTable.hpp"
+
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+
+EncodeTable::EncodeTable(const CanonicalCode &code) {
+	uint32_t symbolLimit = code.getSymbolLimit();
+	table = vector<uint64_t>(symbolLimit, 0);
+	uint32_t maxCodeLength = code.getMaxCodeLength();
+	if (maxCodeLength > 255)
+		throw std::domain_error("The code for a symbol is too long");
+	
+	// The first code of each length is the code after the last code of the previous length, shifted left by one.
+	// Then within each length, codes are assigned to symbols in ascending order. Only packable lengths are needed.
+	uint32_t maxPacked = std::min(maxCodeLength, static_cast<uint32_t>(MAX_PACKED_LENGTH));
+	vector<uint64_t> nextCode(maxPacked + 1, 0);
+	for (uint32_t len = 1; len < maxPacked; len++)
+		nextCode[len + 1] = (nextCode[len] + code.getNumCodesOfLength(len)) << 1;
+	for (uint32_t i = 0; i < symbolLimit; i++) {
+		uint32_t len = code.getCodeLength(i);
+		if (0 < len && len <= maxPacked) {
+			table[i] = nextCode[len] << 8 | len;
+			nextCode[len]++;
+		} else
+			table[i] = len;
+	}
+	
+	// Assign any long codes the same way, stepping through all codes in canonical order
+	// with the current code held as an array of bits, which can be arbitrarily long
+	if (maxCodeLength > maxPacked) {
+		longCodes = vector<vector<char> >(symbolLimit);
+		vector<char> current;
+		for (uint32_t symbol : code.getSymbolsInCodeOrder()) {
+			current.resize(code.getCodeLength(symbol), 0);  // Shift left to the new length
+			if (current.size() > maxPacked)
+				longCodes[symbol] = current;
+			// Increment the code value
+			std::size_t i = current.size();
+			for (; i > 0 && current[i - 1] == 1; i--)
+				current[i - 1] = 0;
+			if (i > 0)
+				current[i - 1] = 1;
+		}
+	}
+}
+
+
+uint32_t EncodeTable::getSymbolLimit() const {
+	return static_cast<uint32_t>(table.size());
+}
+
+
+int EncodeTable::getCodeLength(uint32_t symbol) const {
+	return static_cast<int>(table.at(symbol) & 0xFF);
+}
+
+
+void EncodeTable::writeLongCode(BitOutputStream &out, uint32_t symbol) const {
+	if (table.at(symbol) == 0)
+		throw std::domain_error("No code for given symbol");
+	for (char b : longCodes.at(symbol))
+		out.writeBits(static_cast<uint64_t>(b), 1);
+}
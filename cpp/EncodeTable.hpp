@@ -0,0 +1,90 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "BitIoStream.hpp"
+#include "CanonicalCode.hpp"
+
+
+/* 
+ * A lookup table for encoding symbols of a canonical Huffman code. Immutable.
+ * Each symbol's code value and code length are packed into one 64-bit entry, and all entries
+ * are stored in one array, so encoding a symbol takes one table load and one call to
+ * BitOutputStream::writeBits(). The code values are assigned directly from the code lengths
+ * in canonical order, without building a code tree. For example with the code lengths
+ * A = 1, B = 3, C = 0, D = 2, E = 3 (the example in CanonicalCode.hpp):
+ *   Symbol A: code 0b0, length 1
+ *   Symbol B: code 0b110, length 3
+ *   Symbol C: no code
+ *   Symbol D: code 0b10, length 2
+ *   Symbol E: code 0b111, length 3
+ * Codes longer than MAX_PACKED_LENGTH bits, which only arise from extremely skewed
+ * frequencies, do not fit in an entry and are written by a slower path.
+ */
+class EncodeTable final {
+	
+	/*---- Constants ----*/
+	
+	// The maximum code length stored in a packed entry.
+	public: static const int MAX_PACKED_LENGTH = 56;
+	
+	
+	/*---- Fields ----*/
+	
+	// For each symbol, (codeValue << 8) | codeLength if the code length is at most MAX_PACKED_LENGTH,
+	// otherwise just codeLength (between MAX_PACKED_LENGTH + 1 and 255), or 0 if the symbol has no code.
+	private: std::vector<std::uint64_t> table;
+	
+	// For each symbol with a code longer than MAX_PACKED_LENGTH, the bits of its code
+	// (as in CodeTree::getCode()); empty for all other symbols. Empty if there are no such symbols.
+	private: std::vector<std::vector<char> > longCodes;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Builds an encoding table for the given canonical code. Every code length must be at most 255.
+	public: explicit EncodeTable(const CanonicalCode &code);
+	
+	
+	/*---- Methods ----*/
+	
+	// Returns the number of symbols in this table, which is the symbol limit of its canonical code.
+	public: std::uint32_t getSymbolLimit() const;
+	
+	
+	// Returns the code length of the given symbol, or 0 if it has no code.
+	public: int getCodeLength(std::uint32_t symbol) const;
+	
+	
+	// Writes the code of the given symbol to the given bit output stream.
+	// Throws an exception if the symbol is out of range or has no code.
+	public: void write(BitOutputStream &out, std::uint32_t symbol) const;
+	
+	
+	// Slow path of write(), for a symbol with no code or a long code.
+	private: void writeLongCode(BitOutputStream &out, std::uint32_t symbol) const;
+	
+};
+
+
+
+inline void EncodeTable::write(BitOutputStream &out, std::uint32_t symbol) const {
+	if (symbol >= table.size())
+		throw std::domain_error("Symbol out of range");
+	std::uint64_t entry = table[symbol];
+	int len = static_cast<int>(entry & 0xFF);
+	if (len == 0 || len > MAX_PACKED_LENGTH)
+		writeLongCode(out, symbol);
+	else
+		out.writeBits(entry >> 8, len);
+}
@@ -0,0 +1,688 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include "CanonicalCode.hpp"
+#include "EncodeTable.hpp"
+#include "FrequencyTable.hpp"
+#include "FramedFormat.hpp"
+
+using std::size_t;
+using std::uint8_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+
+/*---- FramedFormat ----*/
+
+const uint8_t FramedFormat::MAGIC[MAGIC_SIZE] = {0xFF, 0x48, 0x55, 0x46};
+
+
+uint32_t FramedFormat::readUint32(const uint8_t *p) {
+	return static_cast<uint32_t>(p[0]) << 24
+	     | static_cast<uint32_t>(p[1]) << 16
+	     | static_cast<uint32_t>(p[2]) <<  8
+	     | static_cast<uint32_t>(p[3]) <<  0;
+}
+
+
+void FramedFormat::writeUint32(uint32_t val, uint8_t *p) {
+	p[0] = static_cast<uint8_t>(val >> 24);
+	p[1] = static_cast<uint8_t>(val >> 16);
+	p[2] = static_cast<uint8_t>(val >>  8);
+	p[3] = static_cast<uint8_t>(val >>  0);
+}
+
+
+uint64_t FramedFormat::readUint64(const uint8_t *p) {
+	return static_cast<uint64_t>(readUint32(p)) << 32 | readUint32(p + 4);
+}
+
+
+void FramedFormat::writeUint64(uint64_t val, uint8_t *p) {
+	writeUint32(static_cast<uint32_t>(val >> 32), p);
+	writeUint32(static_cast<uint32_t>(val >>  0), p + 4);
+}
+
+
+size_t FramedFormat::segmentLength(size_t blockSize, int numStreams, int i) {
+	size_t maxSegment = blockSize / numStreams + (blockSize % numStreams != 0 ? 1 : 0);
+	size_t start = std::min(maxSegment * i, blockSize);
+	return std::min(maxSegment, blockSize - start);
+}
+
+
+/*---- BlockHeader ----*/
+
+BlockHeader::BlockHeader(uint32_t raw, uint32_t body) :
+	rawSize(raw),
+	bodySize(body) {}
+
+
+BlockHeader BlockHeader::read(const uint8_t *p) {
+	return BlockHeader(FramedFormat::readUint32(p), FramedFormat::readUint32(p + 4));
+}
+
+
+void BlockHeader::write(uint8_t *p) const {
+	FramedFormat::writeUint32(rawSize, p);
+	FramedFormat::writeUint32(bodySize, p + 4);
+}
+
+
+bool BlockHeader::isEndMarker() const {
+	return rawSize == 0 && bodySize == 0;
+}
+
+
+bool BlockHeader::isPlausible(uint32_t rawSize, uint32_t bodySize) {
+	return rawSize <= FramedCompressor::MAX_BLOCK_SIZE && rawSize <= static_cast<uint64_t>(bodySize) * 8;
+}
+
+
+/*---- BlockEncoder ----*/
+
+BlockEncoder::BlockEncoder(int streams, uint32_t maxCodeLen) :
+		numStreams(streams),
+		maxCodeLength(maxCodeLen) {
+	if (numStreams < 1 || numStreams > FramedFormat::MAX_STREAMS)
+		throw std::domain_error("Number of streams out of range");
+	if (maxCodeLength < FramedFormat::MIN_CODE_LENGTH || maxCodeLength > FramedFormat::MAX_CODE_LENGTH)
+		throw std::domain_error("Maximum code length out of range");
+}
+
+
+void BlockEncoder::encode(const uint8_t *data, size_t length, vector<uint8_t> &out) const {
+	if (length < 1 || length > UINT32_MAX)
+		throw std::length_error("Block size out of range");
+	
+	// Build a canonical code for this block's byte frequencies
+	FrequencyTable freqs(vector<uint32_t>(FramedFormat::SYMBOL_LIMIT, 0));
+	freqs.incrementBytes(data, length);
+	const CanonicalCode canonCode(freqs.buildCodeLengths(maxCodeLength));
+	const EncodeTable table(canonCode);
+	
+	// Write the block header (sizes filled in at the end), number of substreams and code length table
+	size_t headerStart = out.size();
+	out.resize(headerStart + BlockHeader::SIZE);
+	size_t bodyStart = out.size();
+	out.push_back(static_cast<uint8_t>(numStreams));
+	for (uint32_t i = 0; i < FramedFormat::SYMBOL_LIMIT; i++)  // Each length fits in a byte, due to the maximum code length
+		out.push_back(static_cast<uint8_t>(canonCode.getCodeLength(i)));
+	
+	// Write each substream, then fill in its size in the table
+	size_t sizeTableStart = out.size();
+	out.resize(sizeTableStart + (numStreams - 1) * 4);
+	const uint8_t *segment = data;
+	for (int i = 0; i < numStreams; i++) {
+		size_t streamStart = out.size();
+		size_t segmentLength = FramedFormat::segmentLength(length, numStreams, i);
+		BitOutputStream bout(out);
+		for (size_t j = 0; j < segmentLength; j++)
+			table.write(bout, segment[j]);
+		bout.finish();
+		segment += segmentLength;
+		size_t streamSize = out.size() - streamStart;
+		if (streamSize > UINT32_MAX)
+			throw std::length_error("Substream too large");
+		if (i < numStreams - 1)
+			FramedFormat::writeUint32(static_cast<uint32_t>(streamSize), &out[sizeTableStart + i * 4]);
+	}
+	
+	size_t bodySize = out.size() - bodyStart;
+	if (bodySize > UINT32_MAX)
+		throw std::length_error("Block body too large");
+	BlockHeader(static_cast<uint32_t>(length), static_cast<uint32_t>(bodySize)).write(&out[headerStart]);
+}
+
+
+/*---- BlockDecoder ----*/
+
+BlockDecoder::BlockDecoder(bool multi) :
+	multiSymbol(multi) {}
+
+
+void BlockDecoder::decode(const uint8_t *body, size_t bodySize, uint8_t *out, size_t rawSize) const {
+	// Read the number of substreams and the code length table
+	if (bodySize < 1 + FramedFormat::SYMBOL_LIMIT)
+		throw std::runtime_error("Block body too short");
+	int numStreams = body[0];
+	if (numStreams < 1)
+		throw std::runtime_error("Invalid number of substreams");
+	vector<uint32_t> codeLengths(body + 1, body + 1 + FramedFormat::SYMBOL_LIMIT);
+	const CanonicalCode canonCode(codeLengths);
+	
+	// Locate the substreams and their output segments
+	size_t pos = 1 + FramedFormat::SYMBOL_LIMIT;
+	size_t sizeTableStart = pos;
+	if (bodySize - pos < static_cast<size_t>(numStreams - 1) * 4)
+		throw std::runtime_error("Block body too short");
+	pos += (numStreams - 1) * 4;
+	vector<BitInputStream> streams;
+	vector<uint8_t*> outPos;
+	vector<uint8_t*> outEnd;
+	streams.reserve(numStreams);
+	for (int i = 0; i < numStreams; i++) {
+		size_t streamSize = bodySize - pos;
+		if (i < numStreams - 1) {
+			streamSize = FramedFormat::readUint32(body + sizeTableStart + i * 4);
+			if (streamSize > bodySize - pos)
+				throw std::runtime_error("Substream size exceeds block body");
+		}
+		streams.push_back(BitInputStream(body + pos, streamSize));
+		pos += streamSize;
+		outPos.push_back(out);
+		out += FramedFormat::segmentLength(rawSize, numStreams, i);
+		outEnd.push_back(out);
+	}
+	
+	if (multiSymbol)
+		decodeMulti(MultiDecodeTable(canonCode, MultiDecodeTable::DEFAULT_TABLE_BITS, FramedFormat::SYMBOL_LIMIT), streams, outPos, outEnd);
+	else
+		decodeSingle(DecodeTable(canonCode, DecodeTable::DEFAULT_TABLE_BITS), streams, outPos, outEnd);
+}
+
+
+void BlockDecoder::decodeSingle(const DecodeTable &table, vector<BitInputStream> &streams,
+		vector<uint8_t*> &outPos, const vector<uint8_t*> &outEnd) {
+	
+	// The last segment is the shortest, so every substream has at least that many symbols
+	size_t numStreams = streams.size();
+	size_t common = static_cast<size_t>(outEnd.back() - outPos.back());
+	for (size_t i = 0; i < common; i++) {
+		for (size_t j = 0; j < numStreams; j++) {
+			*outPos[j] = static_cast<uint8_t>(table.read(streams[j]));
+			outPos[j]++;
+		}
+	}
+	
+	// Finish the longer segments
+	for (size_t j = 0; j < numStreams; j++) {
+		for (; outPos[j] != outEnd[j]; outPos[j]++)
+			*outPos[j] = static_cast<uint8_t>(table.read(streams[j]));
+	}
+}
+
+
+void BlockDecoder::decodeMulti(const MultiDecodeTable &table, vector<BitInputStream> &streams,
+		vector<uint8_t*> &outPos, const vector<uint8_t*> &outEnd) {
+	
+	// Advance all substreams together while each has room for a full table entry
+	const size_t maxSymbols = MultiDecodeTable::MAX_SYMBOLS_PER_ENTRY;
+	size_t numStreams = streams.size();
+	uint32_t symbols[MultiDecodeTable::MAX_SYMBOLS_PER_ENTRY];
+	while (true) {
+		bool allHaveRoom = true;
+		for (size_t j = 0; j < numStreams; j++)
+			allHaveRoom &= static_cast<size_t>(outEnd[j] - outPos[j]) >= maxSymbols;
+		if (!allHaveRoom)
+			break;
+		for (size_t j = 0; j < numStreams; j++) {
+			int n = table.read(streams[j], symbols);
+			for (size_t k = 0; k < maxSymbols; k++)
+				outPos[j][k] = static_cast<uint8_t>(symbols[k]);
+			outPos[j] += n;
+		}
+	}
+	
+	// Finish each substream, using multi-symbol lookups only while a whole entry still fits
+	const DecodeTable &single = table.getSingleTable();
+	for (size_t j = 0; j < numStreams; j++) {
+		while (static_cast<size_t>(outEnd[j] - outPos[j]) >= maxSymbols) {
+			int n = table.read(streams[j], symbols);
+			for (size_t k = 0; k < maxSymbols; k++)
+				outPos[j][k] = static_cast<uint8_t>(symbols[k]);
+			outPos[j] += n;
+		}
+		for (; outPos[j] != outEnd[j]; outPos[j]++)
+			*outPos[j] = static_cast<uint8_t>(single.read(streams[j]));
+	}
+}
+
+
+/*---- FramedCompressor ----*/
+
+FramedCompressor::FramedCompressor(size_t blkSize, int numStreams, uint32_t maxCodeLen, unsigned int numThreads, bool withIndex) :
+		blockSize(blkSize),
+		encoder(numStreams, maxCodeLen),
+		blocksPerBatch(static_cast<size_t>(numThreads) * 2),
+		pool(numThreads),
+		writeIndex(withIndex) {
+	if (blkSize < 1 || blkSize > MAX_BLOCK_SIZE)
+		throw std::domain_error("Block size out of range");
+	size_t maxBlocks = MAX_BATCH_SIZE / blockSize;
+	if (blocksPerBatch > maxBlocks)
+		blocksPerBatch = maxBlocks > 0 ? maxBlocks : 1;
+}
+
+
+void FramedCompressor::compress(std::istream &in, std::ostream &out) {
+	vector<uint8_t> buffer(FramedFormat::MAGIC, FramedFormat::MAGIC + FramedFormat::MAGIC_SIZE);
+	const size_t batchSize = blockSize * blocksPerBatch;
+	vector<uint8_t> batch;
+	vector<BlockLocation> directory;
+	uint64_t bufferOffset = 0;  // Position of the buffer's first byte in the output
+	while (true) {
+		batch.clear();
+		while (batch.size() < batchSize && in) {
+			size_t n = batchSize - batch.size();
+			if (n > READ_CHUNK_SIZE)
+				n = READ_CHUNK_SIZE;
+			size_t old = batch.size();
+			batch.resize(old + n);
+			in.read(reinterpret_cast<char*>(&batch[old]), static_cast<std::streamsize>(n));
+			batch.resize(old + static_cast<size_t>(in.gcount()));
+		}
+		size_t length = batch.size();
+		size_t start = buffer.size();
+		encodeBlocks(batch.data(), length, buffer);
+		if (writeIndex)
+			addToDirectory(buffer, start, bufferOffset, directory);
+		if (length < batchSize)
+			break;  // End of stream
+		out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		out.flush();  // Let a downstream reader start on this batch
+		bufferOffset += buffer.size();
+		buffer.clear();
+	}
+	finish(buffer, directory, out);
+}
+
+
+void FramedCompressor::compress(const uint8_t *data, size_t length, std::ostream &out) {
+	vector<uint8_t> buffer(FramedFormat::MAGIC, FramedFormat::MAGIC + FramedFormat::MAGIC_SIZE);
+	vector<BlockLocation> directory;
+	uint64_t bufferOffset = 0;  // Position of the buffer's first byte in the output
+	while (true) {
+		size_t n = std::min(blockSize * blocksPerBatch, length);
+		size_t start = buffer.size();
+		encodeBlocks(data, n, buffer);
+		if (writeIndex)
+			addToDirectory(buffer, start, bufferOffset, directory);
+		data += n;
+		length -= n;
+		if (length == 0)
+			break;
+		out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		bufferOffset += buffer.size();
+		buffer.clear();
+	}
+	finish(buffer, directory, out);
+}
+
+
+void FramedCompressor::finish(vector<uint8_t> &buffer, const vector<BlockLocation> &directory, std::ostream &out) const {
+	buffer.resize(buffer.size() + BlockHeader::SIZE);
+	BlockHeader(0, 0).write(&buffer[buffer.size() - BlockHeader::SIZE]);  // End marker
+	if (writeIndex)
+		BlockIndex::write(directory, buffer);
+	out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+}
+
+
+void FramedCompressor::encodeBlocks(const uint8_t *data, size_t length, vector<uint8_t> &out) {
+	// Each block is encoded into its own vector, so the tasks share no mutable state
+	size_t numBlocks = length / blockSize + (length % blockSize != 0 ? 1 : 0);
+	vector<vector<uint8_t> > encoded(numBlocks);
+	vector<std::future<void> > done;
+	for (size_t i = 0; i < numBlocks; i++) {
+		const uint8_t *block = data + i * blockSize;
+		size_t len = std::min(blockSize, length - i * blockSize);
+		vector<uint8_t> *result = &encoded.at(i);
+		const BlockEncoder *enc = &encoder;
+		done.push_back(pool.submit([enc, block, len, result]() {
+			enc->encode(block, len, *result);
+		}));
+	}
+	
+	// Collect the blocks in order. If any task failed, wait for all the
+	// others to finish (they refer to local variables) before rethrowing.
+	std::exception_ptr error;
+	for (size_t i = 0; i < numBlocks; i++) {
+		try {
+			done.at(i).get();
+		} catch (...) {
+			if (!error)
+				error = std::current_exception();
+		}
+		if (!error)
+			out.insert(out.end(), encoded.at(i).begin(), encoded.at(i).end());
+		vector<uint8_t>().swap(encoded.at(i));  // Free memory early
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+
+void FramedCompressor::addToDirectory(const vector<uint8_t> &buffer, size_t start,
+		uint64_t bufferOffset, vector<BlockLocation> &directory) {
+	uint64_t rawOffset = 0;
+	if (!directory.empty())
+		rawOffset = directory.back().rawOffset + directory.back().rawSize;
+	for (size_t pos = start; pos < buffer.size(); ) {
+		const BlockHeader header = BlockHeader::read(&buffer[pos]);
+		pos += BlockHeader::SIZE;
+		directory.push_back(BlockLocation(bufferOffset + pos, header.bodySize, rawOffset, header.rawSize));
+		pos += header.bodySize;
+		rawOffset += header.rawSize;
+	}
+}
+
+
+/*---- BlockLocation ----*/
+
+BlockLocation::BlockLocation(uint64_t bodyOff, uint32_t bodySz, uint64_t rawOff, uint32_t rawSz) :
+	bodyOffset(bodyOff),
+	bodySize(bodySz),
+	rawOffset(rawOff),
+	rawSize(rawSz) {}
+
+
+/*---- FramedDecompressor ----*/
+
+FramedDecompressor::FramedDecompressor(bool multiSymbol, unsigned int numThreads) :
+		decoder(multiSymbol),
+		blocksPerBatch(static_cast<size_t>(numThreads) * 2) {
+	if (numThreads < 1)
+		throw std::domain_error("At least 1 thread needed");
+	if (numThreads > 1)
+		pool.reset(new ThreadPool(numThreads));
+}
+
+
+vector<BlockLocation> FramedDecompressor::readDirectory(const uint8_t *data, size_t length) {
+	if (length < FramedFormat::MAGIC_SIZE || !std::equal(data, data + FramedFormat::MAGIC_SIZE, FramedFormat::MAGIC))
+		throw std::runtime_error("Invalid magic number");
+	vector<BlockLocation> result;
+	size_t pos = FramedFormat::MAGIC_SIZE;
+	uint64_t rawOffset = 0;
+	while (true) {
+		if (length - pos < BlockHeader::SIZE)
+			throw std::runtime_error("Unexpected end of file");
+		const BlockHeader header = BlockHeader::read(data + pos);
+		pos += BlockHeader::SIZE;
+		if (header.isEndMarker())
+			break;
+		if (!BlockHeader::isPlausible(header.rawSize, header.bodySize))
+			throw std::runtime_error("Invalid block header");
+		if (length - pos < header.bodySize)
+			throw std::runtime_error("Unexpected end of file");
+		result.push_back(BlockLocation(pos, header.bodySize, rawOffset, header.rawSize));
+		pos += header.bodySize;
+		rawOffset += header.rawSize;
+	}
+	return result;
+}
+
+
+uint64_t FramedDecompressor::decompressedSize(const vector<BlockLocation> &directory) {
+	if (directory.empty())
+		return 0;
+	const BlockLocation &last = directory.back();
+	return last.rawOffset + last.rawSize;
+}
+
+
+void FramedDecompressor::decompress(const uint8_t *data, size_t length, vector<uint8_t> &out) {
+	const vector<BlockLocation> directory = readDirectory(data, length);
+	uint64_t size = decompressedSize(directory);
+	if (size > SIZE_MAX)
+		throw std::length_error("Decompressed data too large");
+	out.resize(static_cast<size_t>(size));
+	decodeBlocks(data, directory, out.data());
+}
+
+
+void FramedDecompressor::decompress(std::istream &in, std::ostream &out) {
+	uint8_t magic[FramedFormat::MAGIC_SIZE];
+	readFully(in, magic, sizeof(magic));
+	if (!std::equal(magic, magic + FramedFormat::MAGIC_SIZE, FramedFormat::MAGIC))
+		throw std::runtime_error("Invalid magic number");
+	
+	// Each batch's bodies are read into one buffer, with a directory relative to that buffer and to the batch's output
+	vector<uint8_t> bodies;
+	vector<uint8_t> result;
+	vector<BlockLocation> directory;
+	bool end = false;
+	while (!end) {
+		bodies.clear();
+		directory.clear();
+		while (directory.size() < blocksPerBatch) {
+			uint8_t headerBytes[BlockHeader::SIZE];
+			readFully(in, headerBytes, sizeof(headerBytes));
+			const BlockHeader header = BlockHeader::read(headerBytes);
+			if (header.isEndMarker()) {
+				end = true;
+				break;
+			}
+			if (!BlockHeader::isPlausible(header.rawSize, header.bodySize))
+				throw std::runtime_error("Invalid block header");
+			directory.push_back(BlockLocation(bodies.size(), header.bodySize, decompressedSize(directory), header.rawSize));
+			appendFully(in, header.bodySize, bodies);
+		}
+		result.resize(static_cast<size_t>(decompressedSize(directory)));
+		decodeBlocks(bodies.data(), directory, result.data());
+		out.write(reinterpret_cast<const char*>(result.data()), static_cast<std::streamsize>(result.size()));
+		out.flush();
+	}
+}
+
+
+void FramedDecompressor::readFully(std::istream &in, uint8_t *buffer, size_t length) {
+	in.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(length));
+	if (static_cast<size_t>(in.gcount()) != length)
+		throw std::runtime_error("Unexpected end of file");
+}
+
+
+void FramedDecompressor::appendFully(std::istream &in, size_t length, vector<uint8_t> &out) {
+	while (length > 0) {
+		size_t n = length < READ_CHUNK_SIZE ? length : READ_CHUNK_SIZE;
+		out.resize(out.size() + n);
+		readFully(in, &out[out.size() - n], n);
+		length -= n;
+	}
+}
+
+
+void FramedDecompressor::decodeBlocks(const uint8_t *data, const vector<BlockLocation> &directory, uint8_t *out) {
+	if (!pool) {
+		for (const BlockLocation &loc : directory) {
+			decoder.decode(data + static_cast<size_t>(loc.bodyOffset), loc.bodySize,
+				out + static_cast<size_t>(loc.rawOffset), loc.rawSize);
+		}
+		return;
+	}
+	
+	// Each block writes only its own range of the output, so the tasks share no mutable state
+	vector<std::future<void> > done;
+	done.reserve(directory.size());
+	const BlockDecoder *dec = &decoder;
+	for (const BlockLocation &loc : directory) {
+		const uint8_t *body = data + static_cast<size_t>(loc.bodyOffset);
+		size_t bodySize = loc.bodySize;
+		uint8_t *block = out + static_cast<size_t>(loc.rawOffset);
+		size_t rawSize = loc.rawSize;
+		done.push_back(pool->submit([dec, body, bodySize, block, rawSize]() {
+			dec->decode(body, bodySize, block, rawSize);
+		}));
+	}
+	
+	// Wait for all the tasks even if one fails, because they refer to the caller's arrays
+	std::exception_ptr error;
+	for (std::future<void> &f : done) {
+		try {
+			f.get();
+		} catch (...) {
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+
+/*---- BlockIndex ----*/
+
+const uint8_t BlockIndex::MAGIC[MAGIC_SIZE] = {0x48, 0x49, 0x44, 0x58};
+
+
+void BlockIndex::write(const vector<BlockLocation> &directory, vector<uint8_t> &out) {
+	size_t pos = out.size();
+	out.resize(pos + directory.size() * ENTRY_SIZE + TRAILER_SIZE);
+	for (const BlockLocation &loc : directory) {
+		FramedFormat::writeUint64(loc.bodyOffset, &out[pos +  0]);
+		FramedFormat::writeUint32(loc.bodySize  , &out[pos +  8]);
+		FramedFormat::writeUint64(loc.rawOffset , &out[pos + 12]);
+		FramedFormat::writeUint32(loc.rawSize   , &out[pos + 20]);
+		pos += ENTRY_SIZE;
+	}
+	FramedFormat::writeUint64(directory.size(), &out[pos]);
+	std::copy(MAGIC, MAGIC + MAGIC_SIZE, &out[pos + 8]);
+}
+
+
+bool BlockIndex::readTrailer(const uint8_t *p, uint64_t &numEntries) {
+	if (!std::equal(MAGIC, MAGIC + MAGIC_SIZE, p + 8))
+		return false;
+	numEntries = FramedFormat::readUint64(p);
+	return true;
+}
+
+
+BlockLocation BlockIndex::readEntry(const uint8_t *p) {
+	return BlockLocation(
+		FramedFormat::readUint64(p +  0),
+		FramedFormat::readUint32(p +  8),
+		FramedFormat::readUint64(p + 12),
+		FramedFormat::readUint32(p + 20));
+}
+
+
+/*---- FramedReader ----*/
+
+FramedReader::FramedReader(std::istream &in, bool multiSymbol) :
+		input(in),
+		decoder(multiSymbol) {
+	input.seekg(0, std::ios::end);
+	std::streamoff end = input.tellg();
+	if (end < 0)
+		throw std::runtime_error("Input is not seekable");
+	uint64_t fileSize = static_cast<uint64_t>(end);
+	
+	uint8_t magic[FramedFormat::MAGIC_SIZE];
+	readAt(0, magic, sizeof(magic));
+	if (!std::equal(magic, magic + FramedFormat::MAGIC_SIZE, FramedFormat::MAGIC))
+		throw std::runtime_error("Invalid magic number");
+	if (!readIndex(fileSize))
+		scanBlocks(fileSize);
+}
+
+
+const vector<BlockLocation> &FramedReader::getDirectory() const {
+	return directory;
+}
+
+
+uint64_t FramedReader::size() const {
+	return FramedDecompressor::decompressedSize(directory);
+}
+
+
+void FramedReader::decompressRange(uint64_t offset, size_t length, uint8_t *out) {
+	if (offset > size() || length > size() - offset)
+		throw std::out_of_range("Range extends past end of data");
+	
+	// Find the first block that ends after the offset
+	vector<BlockLocation>::const_iterator it = std::upper_bound(directory.begin(), directory.end(), offset,
+		[](uint64_t off, const BlockLocation &loc) { return off < loc.rawOffset + loc.rawSize; });
+	
+	// Decode each overlapping block, straight into the output if the range covers it whole
+	for (; length > 0; ++it) {
+		const BlockLocation &loc = *it;
+		bodyBuffer.resize(loc.bodySize);
+		readAt(loc.bodyOffset, bodyBuffer.data(), bodyBuffer.size());
+		size_t start = static_cast<size_t>(offset - loc.rawOffset);
+		size_t n = std::min(static_cast<size_t>(loc.rawSize) - start, length);
+		if (n == loc.rawSize)
+			decoder.decode(bodyBuffer.data(), bodyBuffer.size(), out, loc.rawSize);
+		else {
+			blockBuffer.resize(loc.rawSize);
+			decoder.decode(bodyBuffer.data(), bodyBuffer.size(), blockBuffer.data(), blockBuffer.size());
+			std::copy(blockBuffer.begin() + start, blockBuffer.begin() + start + n, out);
+		}
+		out += n;
+		offset += n;
+		length -= n;
+	}
+}
+
+
+bool FramedReader::readIndex(uint64_t fileSize) {
+	if (fileSize < FramedFormat::MAGIC_SIZE + BlockHeader::SIZE + BlockIndex::TRAILER_SIZE)
+		return false;
+	uint8_t trailer[BlockIndex::TRAILER_SIZE];
+	readAt(fileSize - BlockIndex::TRAILER_SIZE, trailer, sizeof(trailer));
+	uint64_t numEntries;
+	if (!BlockIndex::readTrailer(trailer, numEntries))
+		return false;
+	
+	// The blocks must lie between the magic number and the index, with contiguous decompressed ranges
+	uint64_t indexEnd = fileSize - BlockIndex::TRAILER_SIZE;
+	if (numEntries > indexEnd / BlockIndex::ENTRY_SIZE)
+		throw std::runtime_error("Invalid block index");
+	uint64_t indexStart = indexEnd - numEntries * BlockIndex::ENTRY_SIZE;
+	vector<uint8_t> entries(static_cast<size_t>(numEntries * BlockIndex::ENTRY_SIZE));
+	readAt(indexStart, entries.data(), entries.size());
+	uint64_t rawOffset = 0;
+	for (size_t i = 0; i < entries.size(); i += BlockIndex::ENTRY_SIZE) {
+		const BlockLocation loc = BlockIndex::readEntry(&entries[i]);
+		if (loc.bodyOffset < FramedFormat::MAGIC_SIZE + BlockHeader::SIZE || loc.bodyOffset > indexStart
+				|| loc.bodySize > indexStart - loc.bodyOffset || loc.rawOffset != rawOffset
+				|| !BlockHeader::isPlausible(loc.rawSize, loc.bodySize))
+			throw std::runtime_error("Invalid block index");
+		directory.push_back(loc);
+		rawOffset += loc.rawSize;
+	}
+	return true;
+}
+
+
+void FramedReader::scanBlocks(uint64_t fileSize) {
+	uint64_t pos = FramedFormat::MAGIC_SIZE;
+	uint64_t rawOffset = 0;
+	while (true) {
+		uint8_t headerBytes[BlockHeader::SIZE];
+		readAt(pos, headerBytes, sizeof(headerBytes));
+		const BlockHeader header = BlockHeader::read(headerBytes);
+		pos += BlockHeader::SIZE;
+		if (header.isEndMarker())
+			break;
+		if (!BlockHeader::isPlausible(header.rawSize, header.bodySize))
+			throw std::runtime_error("Invalid block header");
+		if (fileSize - pos < header.bodySize)
+			throw std::runtime_error("Unexpected end of file");
+		directory.push_back(BlockLocation(pos, header.bodySize, rawOffset, header.rawSize));
+		pos += header.bodySize;
+		rawOffset += header.rawSize;
+	}
+}
+
+
+void FramedReader::readAt(uint64_t pos, uint8_t *buffer, size_t length) {
+	input.clear();
+	input.seekg(static_cast<std::streamoff>(pos));
+	input.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(length));
+	if (static_cast<size_t>(input.gcount()) != length)
+		throw std::runtime_error("Unexpected end of file");
+}
@@ -0,0 +1,493 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "BitIoStream.hpp"
+#include "DecodeTable.hpp"
+#include "ThreadPool.hpp"
+
+
+/* 
+ * Constants and helpers for the framed file format, which HuffmanCompress writes as an
+ * alternative to its plain format. A framed file consists of a magic number, then any number
+ * of blocks, then an end marker:
+ * - Magic: the 4 bytes FF 48 55 46. No file in the plain format starts with the byte FF,
+ *   because that would mean the code for symbol 0 is 255 bits long.
+ * - Each block: a BlockHeader, then a block body of the size given in the header.
+ * - End marker: a BlockHeader where both sizes are 0.
+ * - Optionally, a block index (see BlockIndex) that lets a reader locate blocks without scanning the file.
+ * Each block body describes its own code, so blocks can be encoded and decoded independently:
+ * - Number of substreams N: 1 byte, between 1 and 255.
+ * - Code lengths: 256 bytes, the canonical code lengths of the byte values 0 to 255.
+ * - Substream sizes: N - 1 big-endian uint32 values, the byte lengths of all substreams but the last.
+ * - Substreams: N Huffman-coded bit streams, each padded to a byte boundary.
+ * The block's data is split into N contiguous segments of ceil(size / N) bytes each (so the last
+ * segments may be shorter or empty), and substream i holds the codes of segment i. There is no EOF
+ * symbol, because the length of every segment is known. A decoder can advance all the substreams in
+ * one loop, so that the table lookups of different substreams do not depend on each other.
+ */
+class FramedFormat final {
+	
+	/*---- Constants ----*/
+	
+	// The number of bytes in the magic number at the start of a framed file.
+	public: static const std::size_t MAGIC_SIZE = 4;
+	
+	// The magic number at the start of a framed file.
+	public: static const std::uint8_t MAGIC[MAGIC_SIZE];
+	
+	// The number of symbols in the code of each block, i.e. the byte values.
+	public: static const std::uint32_t SYMBOL_LIMIT = 256;
+	
+	// The maximum number of substreams in a block.
+	public: static const int MAX_STREAMS = 255;
+	
+	// The shortest allowed maximum code length of a block's code, because
+	// codes of 256 symbols cannot all be shorter than 8 bits.
+	public: static const std::uint32_t MIN_CODE_LENGTH = 8;
+	
+	// The longest code length that the code length table can store.
+	public: static const std::uint32_t MAX_CODE_LENGTH = 255;
+	
+	
+	/*---- Static functions ----*/
+	
+	// Returns the big-endian uint32 value stored at the given position.
+	public: static std::uint32_t readUint32(const std::uint8_t *p);
+	
+	
+	// Stores the given value at the given position as a big-endian uint32.
+	public: static void writeUint32(std::uint32_t val, std::uint8_t *p);
+	
+	
+	// Returns the big-endian uint64 value stored at the given position.
+	public: static std::uint64_t readUint64(const std::uint8_t *p);
+	
+	
+	// Stores the given value at the given position as a big-endian uint64.
+	public: static void writeUint64(std::uint64_t val, std::uint8_t *p);
+	
+	
+	// Returns the number of bytes in segment i of a block with the given size and number of substreams.
+	public: static std::size_t segmentLength(std::size_t blockSize, int numStreams, int i);
+	
+};
+
+
+
+/* 
+ * The 8-byte header at the start of each block of a framed file. It consists of two big-endian uint32
+ * values: the number of bytes of original data in the block, then the number of bytes in the block body.
+ * Both are 0 in the end marker. Knowing the body size lets a reader skip over a block without decoding it.
+ */
+class BlockHeader final {
+	
+	/*---- Fields ----*/
+	
+	// The number of bytes in the block header.
+	public: static const std::size_t SIZE = 8;
+	
+	// The number of bytes of original data in the block, or 0 for the end marker.
+	public: std::uint32_t rawSize;
+	
+	// The number of bytes in the block body that follows the header.
+	public: std::uint32_t bodySize;
+	
+	
+	/*---- Constructor ----*/
+	
+	public: explicit BlockHeader(std::uint32_t raw, std::uint32_t body);
+	
+	
+	/*---- Methods ----*/
+	
+	// Parses the header stored at the given position, which must have at least SIZE bytes.
+	public: static BlockHeader read(const std::uint8_t *p);
+	
+	
+	// Stores this header at the given position, which must have room for SIZE bytes.
+	public: void write(std::uint8_t *p) const;
+	
+	
+	// Tests whether this header is the end marker of a framed file.
+	public: bool isEndMarker() const;
+	
+	
+	// Tests whether a block with the given sizes could have been written by FramedCompressor: at most
+	// MAX_BLOCK_SIZE bytes of data, each coded in at least one bit of the body. Readers check this before
+	// allocating output for a block, so that a small malformed file cannot claim gigabytes of data.
+	public: static bool isPlausible(std::uint32_t rawSize, std::uint32_t bodySize);
+	
+};
+
+
+
+/* 
+ * Compresses data into blocks of the framed format. Each block gets a canonical code that is
+ * optimal for the block's own byte frequencies, among the codes within a maximum code length.
+ */
+class BlockEncoder final {
+	
+	/*---- Fields ----*/
+	
+	// The number of substreams to split each block into, between 1 and FramedFormat::MAX_STREAMS.
+	private: int numStreams;
+	
+	// The longest allowed code, between FramedFormat::MIN_CODE_LENGTH and FramedFormat::MAX_CODE_LENGTH.
+	private: std::uint32_t maxCodeLength;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Constructs a block encoder that splits each block into the given number of substreams,
+	// and limits codes to the given length (between FramedFormat::MIN_CODE_LENGTH and MAX_CODE_LENGTH).
+	public: explicit BlockEncoder(int streams, std::uint32_t maxCodeLen);
+	
+	
+	/*---- Method ----*/
+	
+	// Encodes the given array of bytes as one block (header and body) and appends it to the
+	// given vector. The length must be between 1 and UINT32_MAX.
+	public: void encode(const std::uint8_t *data, std::size_t length, std::vector<std::uint8_t> &out) const;
+	
+};
+
+
+
+/* 
+ * Decompresses blocks of the framed format.
+ */
+class BlockDecoder final {
+	
+	/*---- Field ----*/
+	
+	// Whether to use multi-symbol table lookups instead of single-symbol ones.
+	private: bool multiSymbol;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Constructs a block decoder that uses multi-symbol or single-symbol table lookups.
+	public: explicit BlockDecoder(bool multi);
+	
+	
+	/*---- Methods ----*/
+	
+	// Decodes the given block body, which must be rawSize bytes long when decoded, into the given array.
+	// Throws an exception if the body is malformed or does not decode to exactly rawSize bytes.
+	public: void decode(const std::uint8_t *body, std::size_t bodySize, std::uint8_t *out, std::size_t rawSize) const;
+	
+	
+	// Decodes one symbol per lookup, advancing all substreams together while each has symbols left.
+	private: static void decodeSingle(const DecodeTable &table, std::vector<BitInputStream> &streams,
+		std::vector<std::uint8_t*> &outPos, const std::vector<std::uint8_t*> &outEnd);
+	
+	
+	// Decodes up to several symbols per lookup, advancing all substreams together while each
+	// has room for a full table entry, then finishes each substream one symbol at a time.
+	private: static void decodeMulti(const MultiDecodeTable &table, std::vector<BitInputStream> &streams,
+		std::vector<std::uint8_t*> &outPos, const std::vector<std::uint8_t*> &outEnd);
+	
+};
+
+
+
+/* 
+ * The location of one block within a framed file held in memory, and of its decoded data within the
+ * decompressed output. A list of these for all blocks in order is the block directory of the file.
+ */
+class BlockLocation final {
+	
+	/*---- Fields ----*/
+	
+	// The offset of the block body within the framed file.
+	public: std::uint64_t bodyOffset;
+	
+	// The number of bytes in the block body.
+	public: std::uint32_t bodySize;
+	
+	// The offset of the block's decoded data within the decompressed output.
+	public: std::uint64_t rawOffset;
+	
+	// The number of bytes of decoded data in the block.
+	public: std::uint32_t rawSize;
+	
+	
+	/*---- Constructor ----*/
+	
+	public: explicit BlockLocation(std::uint64_t bodyOff, std::uint32_t bodySz, std::uint64_t rawOff, std::uint32_t rawSz);
+	
+};
+
+
+
+/* 
+ * Compresses a whole input stream into a framed file. The input is cut into blocks of a fixed size,
+ * which are encoded in parallel by a thread pool and written out in their original order. The input is
+ * read in batches of a few blocks per thread, so memory use is bounded regardless of the input size.
+ */
+class FramedCompressor final {
+	
+	/*---- Constants ----*/
+	
+	// The block size used when none is specified, 1 MiB.
+	public: static const std::size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+	
+	// The maximum block size, 1 GiB, which keeps all block sizes well within uint32 range.
+	public: static const std::size_t MAX_BLOCK_SIZE = 1 << 30;
+	
+	// The number of substreams per block used when none is specified.
+	public: static const int DEFAULT_STREAMS = 4;
+	
+	// The maximum code length used when none is specified, which only rules out codes the format cannot store.
+	public: static const std::uint32_t DEFAULT_MAX_CODE_LENGTH = FramedFormat::MAX_CODE_LENGTH;
+	
+	// The largest number of bytes of input in one batch, 256 MiB, unless a single block is larger. This
+	// bounds the memory in flight however large the block size and thread count are.
+	private: static const std::size_t MAX_BATCH_SIZE = 1 << 28;
+	
+	// The largest number of bytes read from a stream at a time. The batch buffer grows only as input
+	// arrives, so a large block size costs memory only for data that was actually read.
+	private: static const std::size_t READ_CHUNK_SIZE = 1 << 20;
+	
+	
+	/*---- Fields ----*/
+	
+	// The number of bytes of input in each block except possibly the last one.
+	private: std::size_t blockSize;
+	
+	// Encodes each block. It has no mutable state, so it can be shared between threads.
+	private: BlockEncoder encoder;
+	
+	// The number of blocks read and encoded together in one batch: two per thread, but
+	// no more than fit in MAX_BATCH_SIZE bytes, and at least one.
+	private: std::size_t blocksPerBatch;
+	
+	// The threads that encode blocks.
+	private: ThreadPool pool;
+	
+	// Whether to write a block index after the end marker.
+	private: bool writeIndex;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Constructs a compressor with the given block size (between 1 and MAX_BLOCK_SIZE), number of substreams
+	// per block, maximum code length (see BlockEncoder), and number of worker threads (at least 1),
+	// which writes a block index if withIndex is true.
+	public: explicit FramedCompressor(std::size_t blkSize, int numStreams, std::uint32_t maxCodeLen, unsigned int numThreads, bool withIndex);
+	
+	
+	/*---- Methods ----*/
+	
+	// Reads the given input stream to its end and writes all of it to the given output stream in the framed format.
+	public: void compress(std::istream &in, std::ostream &out);
+	
+	
+	// Writes the given array of bytes (such as a memory-mapped file) to the given output stream in the
+	// framed format. The blocks are encoded straight from the array, without copying them to a buffer.
+	public: void compress(const std::uint8_t *data, std::size_t length, std::ostream &out);
+	
+	
+	// Encodes the given array as consecutive blocks in parallel, and appends them to the given vector in order.
+	private: void encodeBlocks(const std::uint8_t *data, std::size_t length, std::vector<std::uint8_t> &out);
+	
+	
+	// Appends the end marker and the block index (if enabled) to the given buffer, then writes out the buffer.
+	private: void finish(std::vector<std::uint8_t> &buffer, const std::vector<BlockLocation> &directory, std::ostream &out) const;
+	
+	
+	// Appends the locations of the blocks in buffer[start : buffer.size()] to the given directory,
+	// where bufferOffset is the position in the output file of the start of the buffer.
+	private: static void addToDirectory(const std::vector<std::uint8_t> &buffer, std::size_t start,
+		std::uint64_t bufferOffset, std::vector<BlockLocation> &directory);
+	
+};
+
+
+
+/* 
+ * Decompresses framed files with a thread pool. For a whole file held in memory, the block headers are
+ * scanned first to build the block directory, which gives the total decompressed size and where each
+ * block's data goes, and then all blocks are decoded in parallel, each straight into its final position.
+ * A file read from a stream is instead decoded in batches of a few blocks per thread, so memory use is
+ * bounded and output starts before the input has been read to its end.
+ */
+class FramedDecompressor final {
+	
+	/*---- Constants ----*/
+	
+	// The largest number of bytes of a block body read from a stream at a time. The buffer grows only as
+	// the body arrives, so a malformed header that claims a huge body cannot allocate more than the stream holds.
+	private: static const std::size_t READ_CHUNK_SIZE = 1 << 20;
+	
+	
+	/*---- Fields ----*/
+	
+	// Decodes each block. It has no mutable state, so it can be shared between threads.
+	private: BlockDecoder decoder;
+	
+	// The number of blocks read and decoded together in one batch when reading from a stream.
+	private: std::size_t blocksPerBatch;
+	
+	// The threads that decode blocks, or null for one thread, in which case the calling thread decodes them.
+	private: std::unique_ptr<ThreadPool> pool;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Constructs a decompressor that uses multi-symbol or single-symbol table lookups, and the given
+	// number of threads (at least 1). With 1 thread no worker is started, and blocks are decoded inline.
+	public: explicit FramedDecompressor(bool multiSymbol, unsigned int numThreads);
+	
+	
+	/*---- Methods ----*/
+	
+	// Returns the block directory of the given framed file, after checking its magic number and that
+	// every block lies within the file. Throws an exception if the file is truncated or malformed.
+	public: static std::vector<BlockLocation> readDirectory(const std::uint8_t *data, std::size_t length);
+	
+	
+	// Returns the total number of decompressed bytes described by the given block directory.
+	public: static std::uint64_t decompressedSize(const std::vector<BlockLocation> &directory);
+	
+	
+	// Decompresses the given framed file, replacing the contents of the given vector with the result.
+	public: void decompress(const std::uint8_t *data, std::size_t length, std::vector<std::uint8_t> &out);
+	
+	
+	// Reads a framed file from the given input stream up to its end marker, and writes the decompressed data to
+	// the given output stream, flushing it after each batch. Throws an exception if the file is truncated or malformed.
+	public: void decompress(std::istream &in, std::ostream &out);
+	
+	
+	// Decodes all the blocks in the given directory of the given framed file, in parallel if there are several
+	// threads. The output array must have room for decompressedSize(directory) bytes. Returns when all blocks are done.
+	public: void decodeBlocks(const std::uint8_t *data, const std::vector<BlockLocation> &directory, std::uint8_t *out);
+	
+	
+	// Reads exactly the given number of bytes, or throws an exception if the end of stream comes first.
+	private: static void readFully(std::istream &in, std::uint8_t *buffer, std::size_t length);
+	
+	
+	// Reads exactly the given number of bytes and appends them to the given vector, READ_CHUNK_SIZE
+	// bytes at a time, or throws an exception if the end of stream comes first.
+	private: static void appendFully(std::istream &in, std::size_t length, std::vector<std::uint8_t> &out);
+	
+};
+
+
+
+/* 
+ * The optional block index at the end of a framed file, which is the block directory stored in the file.
+ * It comes after the end marker, so readers that stop at the end marker ignore it. It consists of:
+ * - Entries: for each block in order, its body offset (big-endian uint64), body size (uint32),
+ *   decompressed offset (uint64) and decompressed size (uint32), as in BlockLocation.
+ * - Trailer: the number of entries (big-endian uint64), then the 4 bytes 48 49 44 58 ("HIDX").
+ * A file without an index ends with the end marker, whose last 4 bytes are zero, so a reader can tell
+ * whether an index is present from the last 4 bytes of the file alone.
+ */
+class BlockIndex final {
+	
+	/*---- Constants ----*/
+	
+	// The number of bytes in the magic number at the end of the index.
+	public: static const std::size_t MAGIC_SIZE = 4;
+	
+	// The magic number at the end of the index.
+	public: static const std::uint8_t MAGIC[MAGIC_SIZE];
+	
+	// The number of bytes in each entry.
+	public: static const std::size_t ENTRY_SIZE = 24;
+	
+	// The number of bytes in the trailer, including the magic number.
+	public: static const std::size_t TRAILER_SIZE = 8 + MAGIC_SIZE;
+	
+	
+	/*---- Static functions ----*/
+	
+	// Appends the index for the given block directory to the given vector.
+	public: static void write(const std::vector<BlockLocation> &directory, std::vector<std::uint8_t> &out);
+	
+	
+	// Parses the trailer stored at the given position, which must have at least TRAILER_SIZE bytes. Returns
+	// false if the magic number is absent. Otherwise stores the number of index entries and returns true.
+	public: static bool readTrailer(const std::uint8_t *p, std::uint64_t &numEntries);
+	
+	
+	// Parses the entry stored at the given position, which must have at least ENTRY_SIZE bytes.
+	public: static BlockLocation readEntry(const std::uint8_t *p);
+	
+};
+
+
+
+/* 
+ * Decompresses arbitrary byte ranges of a framed file, decoding only the blocks that overlap each range.
+ * The block directory is taken from the block index if the file has one, otherwise it is built by
+ * seeking from one block header to the next. Either way, no block body is read until it is needed.
+ */
+class FramedReader final {
+	
+	/*---- Fields ----*/
+	
+	// The framed file, which must be seekable and must outlive this object.
+	private: std::istream &input;
+	
+	// Decodes each block that a range overlaps.
+	private: BlockDecoder decoder;
+	
+	// The locations of all blocks in the file, in order.
+	private: std::vector<BlockLocation> directory;
+	
+	// Reused buffers for a block body and for a block that a range covers only in part.
+	private: std::vector<std::uint8_t> bodyBuffer;
+	private: std::vector<std::uint8_t> blockBuffer;
+	
+	
+	/*---- Constructor ----*/
+	
+	// Constructs a reader over the given framed file, which uses multi-symbol or single-symbol
+	// table lookups. Reads the block directory, and throws an exception if the file is malformed.
+	public: explicit FramedReader(std::istream &in, bool multiSymbol);
+	
+	
+	/*---- Methods ----*/
+	
+	// Returns the locations of all blocks in the file, in order.
+	public: const std::vector<BlockLocation> &getDirectory() const;
+	
+	
+	// Returns the total number of decompressed bytes in the file.
+	public: std::uint64_t size() const;
+	
+	
+	// Decompresses the given number of bytes starting at the given offset in the decompressed data,
+	// and stores them in the given array. Throws an exception if the range extends past size().
+	public: void decompressRange(std::uint64_t offset, std::size_t length, std::uint8_t *out);
+	
+	
+	// Reads the block directory from the block index at the end of the given file, or returns false if there is no index.
+	private: bool readIndex(std::uint64_t fileSize);
+	
+	
+	// Builds the block directory by reading each block header and seeking past its body.
+	private: void scanBlocks(std::uint64_t fileSize);
+	
+	
+	// Reads exactly the given number of bytes at the given position of the file.
+	private: void readAt(std::uint64_t pos, std::uint8_t *buffer, std::size_t length);
+	
+};
@@ -7,7 +7,7 @@
  */
 
 #include <algorithm>
-#include <cassert>
+#include <future>
 #include <stdexcept>
 #include <utility>
 #include "FrequencyTable.hpp"
@@ -18,6 +18,15 @@ using std::vector;
 
 
 FrequencyTable::FrequencyTable(const std::vector<uint32_t> &freqs) :
+		frequencies(freqs.cbegin(), freqs.cend()) {
+	if (freqs.size() < 2)
+		throw std::invalid_argument("At least 2 symbols needed");
+	if (freqs.size() > UINT32_MAX)
+		throw std::length_error("Too many symbols");
+}
+
+
+FrequencyTable::FrequencyTable(const std::vector<uint64_t> &freqs) :
 		frequencies(freqs) {
 	if (freqs.size() < 2)
 		throw std::invalid_argument("At least 2 symbols needed");
@@ -31,93 +40,428 @@ uint32_t FrequencyTable::getSymbolLimit() const {
 }
 
 
-uint32_t FrequencyTable::get(uint32_t symbol) const {
+uint64_t FrequencyTable::get(uint32_t symbol) const {
 	return frequencies.at(symbol);
 }
 
 
-void FrequencyTable::set(uint32_t symbol, uint32_t freq) {
+void FrequencyTable::set(uint32_t symbol, uint64_t freq) {
 	frequencies.at(symbol) = freq;
 }
 
 
 void FrequencyTable::increment(uint32_t symbol) {
-	if (frequencies.at(symbol) == UINT32_MAX)
+	if (frequencies.at(symbol) == UINT64_MAX)
 		throw std::overflow_error("Maximum frequency reached");
 	frequencies.at(symbol)++;
 }
 
 
+void FrequencyTable::incrementBytes(const std::uint8_t *data, std::size_t length) {
+	if (frequencies.size() < 256)
+		throw std::domain_error("Symbol limit too small for bytes");
+	uint64_t counts[256] = {};
+	countBytes(data, length, counts);
+	addByteCounts(counts);
+}
+
+
+void FrequencyTable::incrementBytes(const std::uint8_t *data, std::size_t length, ThreadPool &pool) {
+	if (frequencies.size() < 256)
+		throw std::domain_error("Symbol limit too small for bytes");
+	std::size_t numPieces = std::min(static_cast<std::size_t>(pool.size()), length / MIN_BYTES_PER_THREAD);
+	if (numPieces <= 1) {
+		incrementBytes(data, length);
+		return;
+	}
+	
+	// Each task counts its piece into its own row of 64-bit partial counts, so the tasks share no mutable state
+	vector<uint64_t> partial(numPieces * 256, 0);
+	vector<std::future<void> > done;
+	std::size_t pieceSize = length / numPieces;
+	for (std::size_t i = 0; i < numPieces; i++) {
+		const std::uint8_t *piece = data + i * pieceSize;
+		std::size_t len = i < numPieces - 1 ? pieceSize : length - i * pieceSize;
+		uint64_t *counts = &partial[i * 256];
+		done.push_back(pool.submit([piece, len, counts]() {
+			countBytes(piece, len, counts);
+		}));
+	}
+	
+	// Wait for every task before leaving, because they refer to local variables
+	for (std::future<void> &f : done)
+		f.wait();
+	for (std::future<void> &f : done)
+		f.get();
+	uint64_t counts[256] = {};
+	for (std::size_t i = 0; i < numPieces; i++) {
+		for (int j = 0; j < 256; j++)
+			counts[j] += partial[i * 256 + j];
+	}
+	addByteCounts(counts);
+}
+
+
+void FrequencyTable::addByteCounts(const uint64_t counts[256]) {
+	for (int i = 0; i < 256; i++) {
+		if (counts[i] > UINT64_MAX - frequencies[i])
+			throw std::overflow_error("Maximum frequency reached");
+	}
+	for (int i = 0; i < 256; i++)
+		frequencies[i] += counts[i];
+}
+
+
+void FrequencyTable::scaleDown(uint64_t maxTotal) {
+	uint64_t numNonzero = 0;
+	for (uint64_t freq : frequencies) {
+		if (freq > 0)
+			numNonzero++;
+	}
+	if (maxTotal < numNonzero)
+		throw std::domain_error("Maximum total less than number of nonzero frequencies");
+	
+	// If the total does not fit in 64 bits, halve every frequency (rounding up, so
+	// nonzero frequencies stay nonzero) until it does. This keeps the proportions.
+	uint64_t total;
+	while (true) {
+		total = 0;
+		bool overflow = false;
+		for (uint64_t freq : frequencies) {
+			overflow |= freq > UINT64_MAX - total;
+			total += freq;
+		}
+		if (!overflow)
+			break;
+		for (uint64_t &freq : frequencies)
+			freq = (freq >> 1) + (freq & 1);
+	}
+	if (total <= maxTotal)
+		return;
+	
+	// Give each nonzero frequency a share of the budget left after reserving 1 for each of them,
+	// in proportion to its frequency, so the new total is at most maxTotal and no symbol loses its code
+	uint64_t budget = maxTotal - numNonzero;
+	for (uint64_t &freq : frequencies) {
+		if (freq > 0)
+			freq = 1 + multiplyDivide(freq, budget, total);
+	}
+}
+
+
 CodeTree FrequencyTable::buildCodeTree() const {
+	vector<uint32_t> nodes;
+	Workspace work;
+	buildChildEntries(nodes, work);
+	return CodeTree(std::move(nodes), getSymbolLimit());
+}
+
+
+vector<uint32_t> FrequencyTable::buildCodeLengths() const {
+	vector<uint32_t> nodes;
+	Workspace work;
+	buildChildEntries(nodes, work);
+	
+	// Parents have higher indexes than their children, so a single
+	// pass downward from the root reaches every node after its parent
+	vector<uint32_t> result(frequencies.size(), 0);
+	vector<uint32_t> depths(nodes.size() / 2, 0);
+	for (std::size_t i = nodes.size() / 2; i-- > 0; ) {
+		for (int j = 0; j < 2; j++) {
+			uint32_t entry = nodes[i * 2 + j];
+			if (CodeTree::isLeaf(entry))
+				result[CodeTree::getSymbol(entry)] = depths[i] + 1;
+			else
+				depths[entry] = depths[i] + 1;
+		}
+	}
+	return result;
+}
+
+
+vector<uint32_t> FrequencyTable::buildCodeLengths(uint32_t maxLength) const {
+	// Most frequency tables already give an optimal code within the limit,
+	// and then it is kept so that the result agrees with buildCodeTree()
+	vector<uint32_t> result = buildCodeLengths();
+	if (*std::max_element(result.cbegin(), result.cend()) <= maxLength)
+		return result;
+	
+	vector<uint32_t> symbols;
+	vector<uint32_t> temp;
+	sortedLeafSymbols(symbols, temp);
+	const std::size_t n = symbols.size();
+	if (maxLength < 64 && n > (static_cast<uint64_t>(1) << maxLength))
+		throw std::domain_error("Maximum code length too short for the number of symbols");
+	
+	// Package-merge, viewed as the coin collector's problem: each symbol is a coin of each denomination
+	// 2^-1 ... 2^-maxLength, and the cheapest coins worth n-1 in total give each symbol a code length equal
+	// to its number of coins. Starting from the smallest denomination, each list pairs up the items of the
+	// previous list into packages and merges them with the leaves by weight (leaves first on ties).
+	// Only whether each list item is a leaf is remembered; because leaves are merged in sorted order,
+	// the leaves among the first k items of a list are always the k' lowest-frequency symbols.
+	// Each list has fewer than 2n items, so the time and space are O(n * maxLength).
+	vector<vector<bool> > isLeaf(maxLength);
+	vector<uint64_t> weights;
+	for (uint32_t level = 0; level < maxLength; level++) {
+		vector<uint64_t> packages;
+		packages.reserve(weights.size() / 2);
+		for (std::size_t i = 0; i + 1 < weights.size(); i += 2) {
+			uint64_t sum = weights[i] + weights[i + 1];
+			packages.push_back(sum >= weights[i] ? sum : UINT64_MAX);  // Saturate on overflow
+		}
+		weights.clear();
+		vector<bool> &flags = isLeaf[level];
+		std::size_t i = 0;
+		std::size_t j = 0;
+		while (i < n || j < packages.size()) {
+			if (j == packages.size() || (i < n && frequencies[symbols[i]] <= packages[j])) {
+				weights.push_back(frequencies[symbols[i]]);
+				flags.push_back(true);
+				i++;
+			} else {
+				weights.push_back(packages[j]);
+				flags.push_back(false);
+				j++;
+			}
+		}
+	}
+	
+	// Select the first 2n-2 items of the last list, then follow the selected
+	// packages back through the earlier lists, adding 1 to the length of each leaf
+	std::fill(result.begin(), result.end(), 0);
+	std::size_t count = n * 2 - 2;
+	for (uint32_t level = maxLength; level-- > 0 && count > 0; ) {
+		const vector<bool> &flags = isLeaf[level];
+		std::size_t numLeaves = 0;
+		for (std::size_t i = 0; i < count; i++) {
+			if (flags[i])
+				numLeaves++;
+		}
+		for (std::size_t i = 0; i < numLeaves; i++)
+			result[symbols[i]]++;
+		count = (count - numLeaves) * 2;
+	}
+	return result;
+}
+
+
+void FrequencyTable::buildChildEntries(vector<uint32_t> &nodes, Workspace &work) const {
+	if (frequencies.size() > CodeTree::LEAF_FLAG)
+		throw std::length_error("Too many symbols");
+	
 	// Note that if two nodes have the same frequency, then the tie is broken
 	// by which tree contains the lowest symbol. Thus the algorithm has a
-	// deterministic output and does not rely on the queue to break ties.
-	std::priority_queue<NodeWithFrequency> pqueue;
+	// deterministic output, which is the same as repeatedly taking the two
+	// lowest nodes from a priority queue ordered by frequency and lowest symbol.
+	
+	// Leaves sorted by ascending frequency, ties in ascending symbol order
+	sortedLeafSymbols(work.symbols, work.sortBuffer);
+	vector<NodeWithFrequency> &leaves = work.leaves;
+	leaves.clear();
+	for (uint32_t sym : work.symbols)
+		leaves.push_back(NodeWithFrequency(sym | CodeTree::LEAF_FLAG, sym, frequencies[sym]));
+	
+	// Repeatedly tie together the two lowest nodes, taken from the fronts of two sorted queues: the leaves,
+	// and the internal nodes in order of creation. Merged frequencies never decrease, so each new internal
+	// node belongs at the back of its queue, except that it may have to move ahead of nodes with the same
+	// frequency but a higher lowest symbol. Each new internal node is appended to the array after its
+	// children, as the CodeTree layout requires.
+	vector<NodeWithFrequency> &internals = work.internals;
+	internals.clear();
+	nodes.clear();
+	nodes.reserve((leaves.size() - 1) * 2);
+	std::size_t leafHead = 0;
+	std::size_t internalHead = 0;
+	auto popLowest = [&]() -> NodeWithFrequency {
+		if (leafHead < leaves.size() && (internalHead == internals.size()
+				|| leaves[leafHead].precedes(internals[internalHead]))) {
+			leafHead++;
+			return leaves[leafHead - 1];
+		} else {
+			internalHead++;
+			return internals[internalHead - 1];
+		}
+	};
+	for (std::size_t n = leaves.size(); n > 1; n--) {
+		NodeWithFrequency x = popLowest();
+		NodeWithFrequency y = popLowest();
+		nodes.push_back(x.entry);
+		nodes.push_back(y.entry);
+		const NodeWithFrequency node(
+			static_cast<uint32_t>(nodes.size() / 2 - 1),
+			std::min(x.lowestSymbol, y.lowestSymbol),
+			x.frequency + y.frequency);
+		std::size_t i = internals.size();
+		internals.push_back(node);
+		for (; i > internalHead && node.precedes(internals[i - 1]); i--)
+			internals[i] = internals[i - 1];
+		internals[i] = node;
+	}
+}
+
+
+void FrequencyTable::countBytes(const std::uint8_t *data, std::size_t length, uint64_t counts[256]) {
+	// Eight sub-tables of 32-bit counters take 8 KiB, which stays in the L1 cache. Byte i of each group
+	// of eight goes to sub-table i, so a counter can be hit at most once per group. The input is processed
+	// in chunks small enough that no counter can overflow, and each chunk's counts are added to the totals.
+	const int NUM_TABLES = 8;
+	const std::size_t CHUNK_SIZE = static_cast<std::size_t>(1) << 30;
+	while (length > 0) {
+		std::size_t n = std::min(length, CHUNK_SIZE);
+		uint32_t tables[NUM_TABLES][256] = {};
+		std::size_t i = 0;
+		for (; n - i >= NUM_TABLES; i += NUM_TABLES) {
+			tables[0][data[i + 0]]++;
+			tables[1][data[i + 1]]++;
+			tables[2][data[i + 2]]++;
+			tables[3][data[i + 3]]++;
+			tables[4][data[i + 4]]++;
+			tables[5][data[i + 5]]++;
+			tables[6][data[i + 6]]++;
+			tables[7][data[i + 7]]++;
+		}
+		for (; i < n; i++)
+			tables[0][data[i]]++;
+		for (int j = 0; j < 256; j++) {
+			uint64_t sum = 0;
+			for (int k = 0; k < NUM_TABLES; k++)
+				sum += tables[k][j];
+			counts[j] += sum;
+		}
+		data += n;
+		length -= n;
+	}
+}
+
+
+void FrequencyTable::sortedLeafSymbols(vector<uint32_t> &symbols, vector<uint32_t> &temp) const {
+	// Every node's frequency is at most the total, so checking it once rules out overflow when merging nodes
+	uint64_t total = 0;
+	std::size_t numNonzero = 0;
+	for (uint64_t freq : frequencies) {
+		if (freq > UINT64_MAX - total)
+			throw std::overflow_error("Total frequency too large");
+		total += freq;
+		if (freq > 0)
+			numNonzero++;
+	}
+	
+	// If the given vector still holds the result of an earlier call and the same symbols have non-zero frequencies
+	// (as when an adaptive coder rebuilds its code), then only re-sort them, which is fast if few frequencies changed
+	if (numNonzero >= 2 && symbols.size() == numNonzero && resortLeafSymbols(symbols))
+		return;
 	
-	// Add leaves for symbols with non-zero frequency
+	// Collect leaves for symbols with non-zero frequency, in ascending symbol order
+	symbols.clear();
 	{
 		uint32_t i = 0;
-		for (uint32_t freq : frequencies) {
+		for (uint64_t freq : frequencies) {
 			if (freq > 0)
-				pqueue.push(NodeWithFrequency(new Leaf(i), i, freq));
+				symbols.push_back(i);
 			i++;
 		}
 	}
 	
-	// Pad with zero-frequency symbols until queue has at least 2 items
-	{
+	// Pad with zero-frequency symbols until there are at least 2 leaves. These have the lowest
+	// frequency, and are the lowest zero-frequency symbols, so they go at the front in symbol order.
+	if (symbols.size() < 2) {
+		vector<uint32_t> padding;
 		uint32_t i = 0;
-		for (uint32_t freq : frequencies) {
-			if (pqueue.size() >= 2)
+		for (uint64_t freq : frequencies) {
+			if (symbols.size() + padding.size() >= 2)
 				break;
 			if (freq == 0)
-				pqueue.push(NodeWithFrequency(new Leaf(i), i, freq));
+				padding.push_back(i);
 			i++;
 		}
+		symbols.insert(symbols.begin(), padding.begin(), padding.end());
 	}
-	assert(pqueue.size() >= 2);
+	if (symbols.size() < 2)
+		throw std::logic_error("Assertion error");
 	
-	// Repeatedly tie together two nodes with the lowest frequency
-	while (pqueue.size() > 1) {
-		NodeWithFrequency x = popQueue(pqueue);
-		NodeWithFrequency y = popQueue(pqueue);
-		pqueue.push(NodeWithFrequency(
-			new InternalNode(std::move(x.node), std::move(y.node)),
-			std::min(x.lowestSymbol, y.lowestSymbol),
-			x.frequency + y.frequency));
+	// Sort the leaves by ascending frequency with a stable LSD radix sort, 8 bits per pass,
+	// so that ties stay in ascending symbol order. Passes where all digits are equal are skipped.
+	{
+		temp.resize(symbols.size());
+		for (int shift = 0; shift < 64; shift += 8) {
+			std::size_t counts[257] = {};
+			for (uint32_t sym : symbols)
+				counts[((frequencies[sym] >> shift) & 0xFF) + 1]++;
+			if (*std::max_element(counts + 1, counts + 257) == symbols.size())
+				continue;
+			for (int i = 1; i < 257; i++)
+				counts[i] += counts[i - 1];
+			for (uint32_t sym : symbols)
+				temp[counts[(frequencies[sym] >> shift) & 0xFF]++] = sym;
+			symbols.swap(temp);
+		}
+	}
+}
+
+
+bool FrequencyTable::resortLeafSymbols(vector<uint32_t> &symbols) const {
+	for (uint32_t sym : symbols) {
+		if (sym >= frequencies.size() || frequencies[sym] == 0)
+			return false;
+	}
+	// Insertion sort, giving up when it has done more moves than a radix sort would
+	std::size_t movesLeft = symbols.size() * 4;
+	for (std::size_t i = 1; i < symbols.size(); i++) {
+		uint32_t sym = symbols[i];
+		uint64_t freq = frequencies[sym];
+		std::size_t j = i;
+		for (; j > 0 && (frequencies[symbols[j - 1]] > freq
+				|| (frequencies[symbols[j - 1]] == freq && symbols[j - 1] > sym)); j--) {
+			if (movesLeft == 0)
+				return false;
+			movesLeft--;
+			symbols[j] = symbols[j - 1];
+		}
+		symbols[j] = sym;
 	}
+	return true;
+}
+
+
+uint64_t FrequencyTable::multiplyDivide(uint64_t x, uint64_t y, uint64_t z) {
+	// Form the 128-bit product hi:lo from 32-bit halves
+	const uint64_t MASK = UINT32_MAX;
+	uint64_t ll = (x & MASK) * (y & MASK);
+	uint64_t lh = (x & MASK) * (y >> 32);
+	uint64_t hl = (x >> 32) * (y & MASK);
+	uint64_t hh = (x >> 32) * (y >> 32);
+	uint64_t mid = (ll >> 32) + (lh & MASK) + (hl & MASK);
+	uint64_t lo = (mid << 32) | (ll & MASK);
+	uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
 	
-	// Return the remaining node
-	NodeWithFrequency temp = popQueue(pqueue);
-	InternalNode *root = dynamic_cast<InternalNode*>(temp.node.release());
-	CodeTree result(std::move(*root), getSymbolLimit());
-	delete root;
-	return result;
+	// Long division one bit at a time. Because x <= z, hi < z, so the quotient fits in 64 bits.
+	// The remainder stays below z, and the bit shifted out of it is kept in carry.
+	uint64_t remainder = hi;
+	uint64_t quotient = 0;
+	for (int i = 63; i >= 0; i--) {
+		bool carry = (remainder >> 63) != 0;
+		remainder = (remainder << 1) | ((lo >> i) & 1);
+		quotient <<= 1;
+		if (carry || remainder >= z) {
+			remainder -= z;
+			quotient |= 1;
+		}
+	}
+	return quotient;
 }
 
 
-FrequencyTable::NodeWithFrequency::NodeWithFrequency(Node *nd, uint32_t lowSym, uint64_t freq) :
-	node(std::unique_ptr<Node>(nd)),
+FrequencyTable::NodeWithFrequency::NodeWithFrequency(uint32_t ent, uint32_t lowSym, uint64_t freq) :
+	entry(ent),
 	lowestSymbol(lowSym),
 	frequency(freq) {}
 
 
-bool FrequencyTable::NodeWithFrequency::operator<(const NodeWithFrequency &other) const {
-	if (frequency > other.frequency)
-		return true;
-	else if (frequency < other.frequency)
-		return false;
-	else if (lowestSymbol > other.lowestSymbol)
+bool FrequencyTable::NodeWithFrequency::precedes(const NodeWithFrequency &other) const {
+	if (frequency < other.frequency)
 		return true;
-	else if (lowestSymbol < other.lowestSymbol)
+	else if (frequency > other.frequency)
 		return false;
 	else
-		return false;
-}
-
-
-FrequencyTable::NodeWithFrequency FrequencyTable::popQueue(std::priority_queue<NodeWithFrequency> &pqueue) {
-	FrequencyTable::NodeWithFrequency result = std::move(const_cast<NodeWithFrequency&&>(pqueue.top()));
-	pqueue.pop();
-	return result;
+		return lowestSymbol < other.lowestSymbol;
 }
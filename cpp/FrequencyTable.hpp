@@ -8,28 +8,38 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <memory>
-#include <queue>
 #include <vector>
 #include "CodeTree.hpp"
+#include "ThreadPool.hpp"
 
 
 /* 
  * A table of symbol frequencies. Symbols values are numbered from 0 to symbolLimit-1.
  * A frequency table is mainly used like this:
  * 0. Collect the frequencies of symbols in the stream that we want to compress.
- * 1. Build a code tree that is statically optimal for the current frequencies.
+ * 1. Build a code tree that is statically optimal for the current frequencies,
+ *    or code lengths that are optimal subject to a maximum code length.
+ * 2. Optionally scale the frequencies down to a smaller total, keeping their proportions.
  * This implementation is designed to avoid arithmetic overflow - it correctly
  * builds an optimal code tree for any legal number of symbols (2 to UINT32_MAX),
- * with each symbol having a legal frequency (0 to UINT32_MAX).
+ * with each symbol having a legal frequency (0 to UINT64_MAX), as long as the
+ * total of all frequencies is at most UINT64_MAX (or else it throws an exception).
  */
 class FrequencyTable final {
 	
+	/*---- Constant ----*/
+	
+	// The smallest number of bytes that incrementBytes() gives to each thread of a pool. Below this size,
+	// the cost of handing the work to other threads and merging their counts outweighs the speedup.
+	public: static const std::size_t MIN_BYTES_PER_THREAD = 1 << 22;
+	
+	
 	/*---- Field and constructor ----*/
 	
 	// Length at least 2.
-	private: std::vector<std::uint32_t> frequencies;
+	private: std::vector<std::uint64_t> frequencies;
 	
 	
 	// Constructs a frequency table from the given array of frequencies.
@@ -37,6 +47,10 @@ class FrequencyTable final {
 	public: explicit FrequencyTable(const std::vector<std::uint32_t> &freqs);
 	
 	
+	// Constructs a frequency table from the given array of 64-bit frequencies. The array length must be at least 2.
+	public: explicit FrequencyTable(const std::vector<std::uint64_t> &freqs);
+	
+	
 	
 	/*---- Basic methods ----*/
 	
@@ -45,17 +59,36 @@ class FrequencyTable final {
 	
 	
 	// Returns the frequency of the given symbol in this frequency table.
-	public: std::uint32_t get(std::uint32_t symbol) const;
+	public: std::uint64_t get(std::uint32_t symbol) const;
 	
 	
 	// Sets the frequency of the given symbol in this frequency table to the given value.
-	public: void set(std::uint32_t symbol, std::uint32_t freq);
+	public: void set(std::uint32_t symbol, std::uint64_t freq);
 	
 	
 	// Increments the frequency of the given symbol in this frequency table.
 	public: void increment(std::uint32_t symbol);
 	
 	
+	// Increments the frequency of each byte value in the given array, once per occurrence, with the same
+	// result as calling increment() on every byte but much faster. The symbol limit must be at least 256.
+	// Throws an exception (leaving this table unchanged) if any frequency would exceed UINT64_MAX.
+	public: void incrementBytes(const std::uint8_t *data, std::size_t length);
+	
+	
+	// Increments the frequency of each byte value in the given array like incrementBytes(), but splits the array
+	// into one piece per thread of the given pool, counts the pieces in parallel, and adds up the partial counts.
+	// Arrays too small to be worth splitting are counted on the calling thread.
+	public: void incrementBytes(const std::uint8_t *data, std::size_t length, ThreadPool &pool);
+	
+	
+	// If the total of all frequencies exceeds the given maximum, scales every frequency down in proportion so that
+	// the new total is at most the maximum. Nonzero frequencies stay nonzero, so every symbol that had a code still
+	// gets one. The maximum must be at least the number of nonzero frequencies. This is useful for keeping adaptive
+	// statistics bounded, or for storing or transmitting a table with fewer bits per frequency.
+	public: void scaleDown(std::uint64_t maxTotal);
+	
+	
 	
 	/*---- Advanced methods ----*/
 	
@@ -65,23 +98,82 @@ class FrequencyTable final {
 	public: CodeTree buildCodeTree() const;
 	
 	
-	// Helper structure for buildCodeTree()
+	// Returns the code length of each symbol in the tree that buildCodeTree() returns, or 0 for symbols
+	// not in the tree, without building the tree. The result has one element per symbol.
+	public: std::vector<std::uint32_t> buildCodeLengths() const;
+	
+	
+	// Returns code lengths like buildCodeLengths(), but with no code longer than the given maximum length.
+	// The result is optimal among all codes with that limit (the same as buildCodeLengths() if it already fits),
+	// and is computed with the package-merge algorithm otherwise. Throws an exception if the maximum length
+	// is too short to give every symbol in the tree a code, i.e. 2^maxLength is less than their number.
+	public: std::vector<std::uint32_t> buildCodeLengths(std::uint32_t maxLength) const;
+	
+	
+	public: class Workspace;
+	
+	// Computes the child entries of the tree that buildCodeTree() returns, in the layout of CodeTree, into
+	// the given vector. The tree is built in time linear in the number of symbols, apart from a radix sort of the
+	// frequencies. The temporary arrays are kept in the given workspace, so that repeated builds with the same
+	// vector and workspace (as in adaptive coding) reuse their memory instead of allocating.
+	public: void buildChildEntries(std::vector<std::uint32_t> &nodes, Workspace &work) const;
+	
+	
+	// Adds the given byte value counts to the frequencies, after checking that none would exceed UINT64_MAX.
+	private: void addByteCounts(const std::uint64_t counts[256]);
+	
+	
+	// Adds the number of occurrences of each byte value in the given array to the given counts. The bytes
+	// are spread over several interleaved sub-tables, so that runs of equal bytes do not make each increment
+	// wait for the previous one to the same counter (a store-to-load forwarding stall).
+	private: static void countBytes(const std::uint8_t *data, std::size_t length, std::uint64_t counts[256]);
+	
+	
+	// Returns floor(x * y / z) without overflow, for x <= z and z > 0. The result is at most y.
+	private: static std::uint64_t multiplyDivide(std::uint64_t x, std::uint64_t y, std::uint64_t z);
+	
+	
+	// Stores the symbols that get a leaf in the tree, sorted by ascending frequency and then ascending symbol,
+	// into the given vector, using the other given vector as a buffer. These are the symbols with non-zero frequency,
+	// padded with the lowest zero-frequency symbols to at least 2. Throws an exception if the total of all frequencies
+	// exceeds UINT64_MAX.
+	private: void sortedLeafSymbols(std::vector<std::uint32_t> &symbols, std::vector<std::uint32_t> &temp) const;
+	
+	
+	// Sorts the given distinct symbols like sortedLeafSymbols(), if they all have non-zero frequency and are nearly sorted
+	// already. Returns false (leaving the vector in an arbitrary order) if a symbol has zero frequency or is out of range,
+	// or if sorting would take more than a few moves per symbol.
+	private: bool resortLeafSymbols(std::vector<std::uint32_t> &symbols) const;
+	
+	
+	// Helper structure for buildChildEntries()
 	private: class NodeWithFrequency {
 		
-		public: std::unique_ptr<Node> node;
+		public: std::uint32_t entry;  // A leaf or internal node entry, as in CodeTree
 		public: std::uint32_t lowestSymbol;
-		public: std::uint64_t frequency;  // Using wider type prevents overflow
+		public: std::uint64_t frequency;  // At most the total of all frequencies, so sums cannot overflow
 		
 		
-		public: explicit NodeWithFrequency(Node *nd, std::uint32_t lowSym, std::uint64_t freq);
+		public: explicit NodeWithFrequency(std::uint32_t ent, std::uint32_t lowSym, std::uint64_t freq);
 		
 		
-		// Sort by ascending frequency, breaking ties by ascending symbol value.
-		public: bool operator<(const NodeWithFrequency &other) const;
+		// Tests whether this node comes before the given node, i.e. has lower frequency,
+		// breaking ties by lower symbol value. Two distinct nodes never tie completely.
+		public: bool precedes(const NodeWithFrequency &other) const;
 		
 	};
 	
 	
-	private: static NodeWithFrequency popQueue(std::priority_queue<NodeWithFrequency> &pqueue);
+	// Temporary arrays for buildChildEntries(), which keep their memory between calls.
+	public: class Workspace final {
+		
+		friend class FrequencyTable;
+		
+		private: std::vector<std::uint32_t> symbols;
+		private: std::vector<std::uint32_t> sortBuffer;
+		private: std::vector<NodeWithFrequency> leaves;
+		private: std::vector<NodeWithFrequency> internals;
+		
+	};
 	
 };
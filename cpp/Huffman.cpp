@@ -0,0 +1,106 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <stdexcept>
+#include "BitIoStream.hpp"
+#include "CanonicalCode.hpp"
+#include "DecodeTable.hpp"
+#include "Dictionary.hpp"
+#include "EncodeTable.hpp"
+#include "FramedFormat.hpp"
+#include "FrequencyTable.hpp"
+#include "Huffman.hpp"
+
+using std::uint8_t;
+using std::uint32_t;
+using std::size_t;
+using std::vector;
+
+
+size_t Huffman::compressBound(size_t length) {
+	// 257 + ceil(9 * (length + 1) / 8), without overflow for any realistic length
+	return 257 + (length + 1) + (length + 8) / 8;
+}
+
+
+void Huffman::compress(const uint8_t *data, size_t length, vector<uint8_t> &out) {
+	// Same steps as HuffmanCompress for the plain format
+	FrequencyTable freqs(vector<uint32_t>(257, 0));
+	freqs.incrementBytes(data, length);
+	freqs.increment(256);  // EOF symbol gets a frequency of 1
+	const CanonicalCode canonCode(freqs.buildCodeLengths(FramedFormat::MAX_CODE_LENGTH));
+	const EncodeTable table(canonCode);
+	
+	out.clear();
+	out.reserve(compressBound(length));
+	BitOutputStream bout(out);
+	writeCodeLengthTable(canonCode, false, bout);
+	writeData(data, length, table, bout);
+}
+
+
+void Huffman::decompress(const uint8_t *data, size_t length, vector<uint8_t> &out) {
+	if (length > 0 && data[0] == FramedFormat::MAGIC[0]) {
+		FramedDecompressor decomp(false, 1);
+		decomp.decompress(data, length, out);
+		return;
+	}
+	
+	// Read the code length table of the plain format
+	BitInputStream bin(data, length);
+	uint32_t first = static_cast<uint32_t>(bin.readBits(8));
+	if (first == Dictionary::MARKER)
+		throw std::runtime_error("Data compressed with a dictionary");
+	const CanonicalCode canonCode = readCodeLengthTable(first, bin);
+	const DecodeTable table(canonCode, DecodeTable::DEFAULT_TABLE_BITS);
+	
+	out.clear();
+	while (true) {
+		uint32_t symbol = table.read(bin);
+		if (symbol == 256)  // EOF symbol
+			break;
+		out.push_back(static_cast<uint8_t>(symbol));
+	}
+}
+
+
+void Huffman::writeCodeLengthTable(const CanonicalCode &code, bool compact, BitOutputStream &out) {
+	if (compact) {
+		out.writeBits(COMPACT_MARKER, 8);
+		code.writeCompact(out);
+		return;
+	}
+	for (uint32_t i = 0; i < code.getSymbolLimit(); i++) {
+		uint32_t val = code.getCodeLength(i);
+		// For this file format, we only support codes up to 255 bits long
+		if (val >= 256)
+			throw std::domain_error("The code for a symbol is too long");
+		// Write value as 8 bits in big endian
+		out.writeBits(val, 8);
+	}
+}
+
+
+void Huffman::writeData(const uint8_t *data, size_t length, const EncodeTable &table, BitOutputStream &out) {
+	for (size_t i = 0; i < length; i++)
+		table.write(out, data[i]);
+	table.write(out, 256);  // EOF
+	out.finish();
+}
+
+
+CanonicalCode Huffman::readCodeLengthTable(uint32_t first, BitInputStream &in) {
+	if (first == COMPACT_MARKER)
+		return CanonicalCode::readCompact(in, 257);
+	vector<uint32_t> codeLengths(1, first);
+	for (int i = 1; i < 257; i++) {
+		// For this file format, we read 8 bits in big endian
+		codeLengths.push_back(static_cast<uint32_t>(in.readBits(8)));
+	}
+	return CanonicalCode(codeLengths);
+}
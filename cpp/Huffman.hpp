@@ -0,0 +1,79 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BitIoStream.hpp"
+#include "CanonicalCode.hpp"
+#include "EncodeTable.hpp"
+
+
+/* 
+ * In-memory compression and decompression, for programs that link the library libhuffman.a (built by the
+ * Makefile from every module except the applications) instead of running the applications on files.
+ * compress() and decompress() do not read or write files or iostreams. compress() writes the plain format,
+ * exactly the bytes that "HuffmanCompress" writes without options, and decompress() reads everything that
+ * "HuffmanDecompress" reads without options. Both applications also use the plain format functions below.
+ * Each function replaces the contents of the given output vector, so a caller that passes the same vector
+ * to many calls keeps its capacity. compress() reserves its worst-case size and then writes straight into
+ * it, so it never reallocates. decompress() writes framed data straight into a vector of the decoded size,
+ * but the plain format does not record that size, so it grows the vector as it decodes.
+ * The default build flags enable a sanitizer, which programs linking the library then also need, so for
+ * production build it with optimization only, for example: make CXXFLAGS="-std=c++11 -O2" libhuffman.a
+ */
+class Huffman final {
+	
+	/*---- Constants ----*/
+	
+	// The first byte of data in the plain format with a compact code length table (see CanonicalCode::writeCompact()).
+	// No data with the ordinary code length table starts with it, because that would mean the code for symbol 0 is 254 bits long.
+	public: static const int COMPACT_MARKER = 0xFE;
+	
+	// The shortest allowed maximum code length in the plain format, because codes
+	// of its 257 symbols (the byte values and EOF) cannot all be shorter than 9 bits.
+	public: static const std::uint32_t MIN_CODE_LENGTH = 9;
+	
+	
+	/*---- Functions ----*/
+	
+	// Returns the largest size that compress() can produce for the given input length. A Huffman code is never
+	// longer in total than a flat code of 9 bits per symbol, so this is the 257-byte code length table plus
+	// 9 bits per byte and for the EOF symbol, rounded up.
+	public: static std::size_t compressBound(std::size_t length);
+	
+	
+	// Compresses the given bytes in the plain format, replacing the contents of the given vector with the result.
+	// The vector's capacity is raised to compressBound(length) first if it is smaller, so it is never reallocated while writing.
+	public: static void compress(const std::uint8_t *data, std::size_t length, std::vector<std::uint8_t> &out);
+	
+	
+	// Decompresses the given data in the plain format (with either kind of code length table) or the framed format,
+	// replacing the contents of the given vector with the result. Throws an exception if the data is truncated or
+	// malformed, or runtime_error if it was compressed with a dictionary (see Dictionary.hpp), which is not supported here.
+	public: static void decompress(const std::uint8_t *data, std::size_t length, std::vector<std::uint8_t> &out);
+	
+	
+	/*---- Plain format functions ----*/
+	
+	// Writes the code length table of the plain format for the given code: 257 bytes of code lengths, or if compact
+	// is true, COMPACT_MARKER and then the code in the compact format. Throws domain_error if a code is too long for a byte.
+	public: static void writeCodeLengthTable(const CanonicalCode &code, bool compact, BitOutputStream &out);
+	
+	
+	// Writes the codes of the given bytes and of the EOF symbol (256) with the given table, and finishes the given stream.
+	public: static void writeData(const std::uint8_t *data, std::size_t length, const EncodeTable &table, BitOutputStream &out);
+	
+	
+	// Reads the rest of the code length table of the plain format after its given first byte,
+	// which is COMPACT_MARKER or else the first code length, and returns the code.
+	public: static CanonicalCode readCodeLengthTable(std::uint32_t first, BitInputStream &in);
+	
+};
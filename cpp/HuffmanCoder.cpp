@@ -18,20 +18,15 @@ int HuffmanDecoder::read() {
 	if (codeTree == nullptr)
 		throw std::logic_error("Code tree is null");
 	
-	const InternalNode *currentNode = &codeTree->root;
+	std::uint32_t node = codeTree->getRoot();
 	while (true) {
 		int temp = input.readNoEof();
-		const Node *nextNode;
-		if      (temp == 0) nextNode = currentNode->leftChild .get();
-		else if (temp == 1) nextNode = currentNode->rightChild.get();
-		else throw std::logic_error("Assertion error: Invalid value from readNoEof()");
-		
-		if (dynamic_cast<const Leaf*>(nextNode) != nullptr)
-			return dynamic_cast<const Leaf*>(nextNode)->symbol;
-		else if (dynamic_cast<const InternalNode*>(nextNode))
-			currentNode = dynamic_cast<const InternalNode*>(nextNode);
-		else
-			throw std::logic_error("Assertion error: Illegal node type");
+		if (temp != 0 && temp != 1)
+			throw std::logic_error("Assertion error: Invalid value from readNoEof()");
+		std::uint32_t entry = codeTree->getChild(node, temp);
+		if (CodeTree::isLeaf(entry))
+			return static_cast<int>(CodeTree::getSymbol(entry));
+		node = entry;
 	}
 }
 
@@ -43,6 +38,17 @@ HuffmanEncoder::HuffmanEncoder(BitOutputStream &out) :
 void HuffmanEncoder::write(std::uint32_t symbol) {
 	if (codeTree == nullptr)
 		throw std::logic_error("Code tree is null");
-	for (char b : codeTree->getCode(symbol))
-		output.write(b);
+	// Pack the code into words so that the stream is called once per 64 bits, not once per bit
+	std::uint64_t bits = 0;
+	int numBits = 0;
+	for (char b : codeTree->getCode(symbol)) {
+		bits = (bits << 1) | static_cast<std::uint64_t>(b);
+		numBits++;
+		if (numBits == 64) {
+			output.writeBits(bits, numBits);
+			bits = 0;
+			numBits = 0;
+		}
+	}
+	output.writeBits(bits, numBits);
 }
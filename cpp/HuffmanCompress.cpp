@@ -1,11 +1,34 @@
 /* 
  * Compression application using static Huffman coding
  * 
- * Usage: HuffmanCompress InputFile OutputFile
+ * Usage: HuffmanCompress [--max-code-length=N] [--compact] [--dictionary=FILE] [--framed] [--block-size=N] [--streams=N] [--threads=N] [--index] InputFile OutputFile
  * Then use the corresponding "HuffmanDecompress" application to recreate the original input file.
  * Note that the application uses an alphabet of 257 symbols - 256 symbols for the byte values
  * and 1 symbol for the EOF marker. The compressed file format starts with a list of 257
  * code lengths, treated as a canonical code, and then followed by the Huffman-coded data.
+ * For the plain format, the --compact option instead starts the file with the byte FE, followed by the code lengths in
+ * the compact format of CanonicalCode::writeCompact() and then the data, in one bit stream.
+ * This saves most of the 257 bytes for small inputs. No file in the plain format starts with
+ * the byte FE, because that would mean the code for symbol 0 is 254 bits long.
+ * The --dictionary option instead uses the pre-trained code in the given dictionary file (made by
+ * "HuffmanTrain"), so the frequencies are not counted and the file has no code length table at all,
+ * only the dictionary ID (see Dictionary.hpp). This suits small messages like the training samples.
+ * A dictionary's code lengths were fixed by "HuffmanTrain", so --max-code-length is not accepted with it,
+ * and --compact, --dictionary and the framed format (see below) cannot be combined with each other.
+ * The --max-code-length option limits the length of every code (between 9 and 255, default 255, and the
+ * framed format also allows 8), for example to the number of index bits of a decoder's lookup table,
+ * so that every symbol decodes in a single lookup. The code is then optimal among codes within that limit, which costs little.
+ * With the --framed option, or any of the options after it, the application instead writes the
+ * framed format described in FramedFormat.hpp. The input is read only once and cut into blocks of
+ * the given size (default 1 MiB), each with its own code. The blocks are compressed in parallel by the
+ * given number of threads (default: one per hardware thread), and the codes of each block are split
+ * into the given number of substreams (between 1 and 255, default 4) for faster decompression.
+ * The --index option appends a block index, which lets a reader decompress any byte range quickly.
+ * Either file name can be "-" for standard input or output. In the framed format, input that is
+ * not a regular file (such as a pipe) is compressed as it streams in, with bounded memory use, and
+ * each batch of blocks is written out as soon as it is done, so the application works in a pipeline.
+ * The plain format needs two passes over the data, so such input is first read into memory whole.
+ * Its first pass counts the byte frequencies of a large input in parallel, with one thread per hardware thread.
  * 
  * Copyright (c) Project Nayuki
  * 
@@ -13,79 +36,121 @@
  * https://github.com/nayuki/Reference-Huffman-coding
  */
 
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
-#include <stdexcept>
 #include <vector>
 #include "BitIoStream.hpp"
 #include "CanonicalCode.hpp"
+#include "CommandLine.hpp"
+#include "Dictionary.hpp"
+#include "EncodeTable.hpp"
+#include "FramedFormat.hpp"
 #include "FrequencyTable.hpp"
-#include "HuffmanCoder.hpp"
+#include "Huffman.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
 
+using std::uint8_t;
 using std::uint32_t;
 
 
 int main(int argc, char *argv[]) {
 	// Handle command line arguments
-	if (argc != 3) {
-		std::cerr << "Usage: " << argv[0] << " InputFile OutputFile" << std::endl;
+	bool framed = false;
+	bool compact = false;
+	bool withIndex = false;
+	const char *dictionaryFile = nullptr;
+	int blockSize = static_cast<int>(FramedCompressor::DEFAULT_BLOCK_SIZE);
+	int numStreams = FramedCompressor::DEFAULT_STREAMS;
+	int numThreads = static_cast<int>(ThreadPool::defaultThreadCount());
+	int maxCodeLength = static_cast<int>(FramedCompressor::DEFAULT_MAX_CODE_LENGTH);
+	bool limited = false;
+	int argi = 1;
+	for (; argi < argc && std::strncmp(argv[argi], "--", 2) == 0; argi++) {
+		const char *arg = argv[argi];
+		if (std::strcmp(arg, "--compact") == 0)
+			compact = true;
+		else if (std::strncmp(arg, "--dictionary=", 13) == 0 && arg[13] != '\0')
+			dictionaryFile = arg + 13;
+		else if (std::strcmp(arg, "--index") == 0) {
+			withIndex = true;
+			framed = true;
+		} else if (std::strcmp(arg, "--framed") == 0
+				|| CommandLine::parseIntOption(arg, "--block-size=", 1, static_cast<long>(FramedCompressor::MAX_BLOCK_SIZE), blockSize)
+				|| CommandLine::parseIntOption(arg, "--streams=", 1, FramedFormat::MAX_STREAMS, numStreams)
+				|| CommandLine::parseIntOption(arg, "--threads=", 1, 1024, numThreads))
+			framed = true;
+		else if (CommandLine::parseIntOption(arg, "--max-code-length=", FramedFormat::MIN_CODE_LENGTH, FramedFormat::MAX_CODE_LENGTH, maxCodeLength))
+			limited = true;
+		else {
+			argi = argc;  // Show usage
+			break;
+		}
+	}
+	// The compact table, the dictionary and the framed format exclude each other, and a dictionary has its own code lengths
+	bool dictionary = dictionaryFile != nullptr;
+	// A block's code has no EOF symbol, so only the framed format allows codes of 8 bits
+	bool tooShort = !framed && static_cast<uint32_t>(maxCodeLength) < Huffman::MIN_CODE_LENGTH;
+	if (argc - argi != 2 || (framed && dictionary) || (compact && (framed || dictionary)) || (limited && dictionary) || tooShort) {
+		std::cerr << "Usage: " << argv[0] << " [--max-code-length=N] [--compact] [--dictionary=FILE] [--framed] [--block-size=N] [--streams=N] [--threads=N] [--index] InputFile OutputFile" << std::endl;
 		return EXIT_FAILURE;
 	}
-	const char *inputFile  = argv[1];
-	const char *outputFile = argv[2];
+	const char *inputFile  = argv[argi + 0];
+	const char *outputFile = argv[argi + 1];
 	
-	// Read input file once to compute symbol frequencies.
-	// The resulting generated code is optimal for static Huffman coding and also canonical.
-	std::ifstream in(inputFile, std::ios::binary);
-	FrequencyTable freqs(std::vector<uint32_t>(257, 0));
-	while (true) {
-		int b = in.get();
-		if (b == EOF)
-			break;
-		if (b < 0 || b > 255)
-			throw std::logic_error("Assertion error");
-		freqs.increment(static_cast<uint32_t>(b));
+	std::filebuf inFile;
+	std::filebuf outFile;
+	if (framed) {
+		std::ostream out(CommandLine::openOutput(outputFile, outFile));
+		FramedCompressor comp(static_cast<std::size_t>(blockSize), numStreams,
+			static_cast<uint32_t>(maxCodeLength), static_cast<unsigned int>(numThreads), withIndex);
+		if (MappedInput::isRegularFile(inputFile)) {
+			const MappedInput in(inputFile);
+			comp.compress(in.data(), in.size(), out);
+		} else {  // Stream a pipe or standard input with bounded memory
+			std::istream in(CommandLine::openInput(inputFile, inFile));
+			comp.compress(in, out);
+		}
+		return EXIT_SUCCESS;
 	}
+	
+	// Map the input file (or read it whole if it is not a regular file)
+	const MappedInput in(inputFile);
+	const uint8_t *data = in.data();
+	const std::size_t length = in.size();
+	if (dictionaryFile != nullptr) {
+		// Use the pre-trained code, which needs neither a frequency pass nor a code length table
+		std::filebuf dictFile;
+		std::istream dictIn(CommandLine::openInput(dictionaryFile, dictFile));
+		const Dictionary dict = Dictionary::read(dictIn);
+		std::ostream out(CommandLine::openOutput(outputFile, outFile));
+		BitOutputStream bout(out);
+		dict.writeHeader(bout);
+		Huffman::writeData(data, length, dict.getEncodeTable(), bout);
+		return EXIT_SUCCESS;
+	}
+	
+	// Count symbol frequencies. The resulting generated code is optimal
+	// for static Huffman coding within the maximum code length, and also canonical.
+	FrequencyTable freqs(std::vector<uint32_t>(257, 0));
+	ThreadPool pool(ThreadPool::defaultThreadCount());
+	freqs.incrementBytes(data, length, pool);
 	freqs.increment(256);  // EOF symbol gets a frequency of 1
-	CodeTree code = freqs.buildCodeTree();
-	const CanonicalCode canonCode(code, freqs.getSymbolLimit());
-	// Replace code tree with canonical one. For each symbol,
-	// the code value may change but the code length stays the same.
-	code = canonCode.toCodeTree();
+	const CanonicalCode canonCode(freqs.buildCodeLengths(static_cast<uint32_t>(maxCodeLength)));
+	// Assign the canonical code values from the code lengths
+	const EncodeTable table(canonCode);
 	
-	// Read input file again, compress with Huffman coding, and write output file
-	in.clear();
-	in.seekg(0);
-	std::ofstream out(outputFile, std::ios::binary);
+	// Compress the input data with Huffman coding, and write output file
+	std::ostream out(CommandLine::openOutput(outputFile, outFile));
 	BitOutputStream bout(out);
 	try {
 		
-		// Write code length table
-		for (uint32_t i = 0; i < canonCode.getSymbolLimit(); i++) {
-			uint32_t val = canonCode.getCodeLength(i);
-			// For this file format, we only support codes up to 255 bits long
-			if (val >= 256)
-				throw std::domain_error("The code for a symbol is too long");
-			// Write value as 8 bits in big endian
-			for (int j = 7; j >= 0; j--)
-				bout.write((val >> j) & 1);
-		}
-		
-		HuffmanEncoder enc(bout);
-		enc.codeTree = &code;
-		while (true) {
-			// Read and encode one byte
-			int symbol = in.get();
-			if (symbol == EOF)
-				break;
-			if (symbol < 0 || symbol > 255)
-				throw std::logic_error("Assertion error");
-			enc.write(static_cast<uint32_t>(symbol));
-		}
-		enc.write(256);  // EOF
-		bout.finish();
+		Huffman::writeCodeLengthTable(canonCode, compact, bout);
+		Huffman::writeData(data, length, table, bout);
 		return EXIT_SUCCESS;
 		
 	} catch (const char *msg) {
@@ -1,8 +1,21 @@
 /* 
  * Decompression application using static Huffman coding
  * 
- * Usage: HuffmanDecompress InputFile OutputFile
+ * Usage: HuffmanDecompress [--decoder=single|multi] [--dictionary=FILE]... [--threads=N] [--offset=N] [--length=N] InputFile OutputFile
  * This decompresses files generated by the "HuffmanCompress" application.
+ * The decoder option selects between table lookups that decode one symbol each (the default)
+ * and table lookups that can decode several short codes at once. Both the plain format and
+ * the framed format (see FramedFormat.hpp) are accepted, and are told apart by the first byte,
+ * as is the plain format with a compact code length table.
+ * A file compressed with a dictionary needs the --dictionary option with the same dictionary file.
+ * The option can be given several times, and the dictionary is chosen by the ID stored in the file.
+ * Each dictionary's decoding tables are built once, when it is loaded.
+ * Either file name can be "-" for standard input or output. A regular input file is memory-mapped,
+ * and the blocks of a framed file are decoded in parallel by the given number of threads (default:
+ * one per hardware thread), each straight into its final position in the memory-mapped output file.
+ * Any other input (such as a pipe) is decoded as it streams in, with bounded memory use.
+ * The offset and length options select a byte range of the decompressed data of a framed file
+ * (default: from the start, to the end), and only the blocks overlapping that range are decoded.
  * 
  * Copyright (c) Project Nayuki
  * 
@@ -10,58 +23,127 @@
  * https://github.com/nayuki/Reference-Huffman-coding
  */
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include "BitIoStream.hpp"
 #include "CanonicalCode.hpp"
-#include "FrequencyTable.hpp"
-#include "HuffmanCoder.hpp"
+#include "CommandLine.hpp"
+#include "DecodeTable.hpp"
+#include "Dictionary.hpp"
+#include "FramedFormat.hpp"
+#include "Huffman.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
 
+using std::uint8_t;
 using std::uint32_t;
 
 
+static const std::size_t BUFFER_SIZE = 65536;
+
+
+static int decompressPlain(BitInputStream &bin, std::ostream &out, bool multiSymbol, const std::vector<Dictionary> &dictionaries);
+static const Dictionary &findDictionary(const std::vector<Dictionary> &dictionaries, uint32_t id);
+static void decodeSingle(BitInputStream &bin, const DecodeTable &table, std::ostream &out);
+static void decodeMulti(BitInputStream &bin, const MultiDecodeTable &table, std::ostream &out);
+static void appendByte(std::vector<char> &buffer, uint32_t symbol, std::ostream &out);
+static void decompressFramed(const uint8_t *data, std::size_t length, const char *outputFile, bool multiSymbol, unsigned int numThreads);
+static int decompressRange(std::istream &in, std::ostream &out, bool multiSymbol, std::uint64_t offset, std::uint64_t length);
+
+
 int main(int argc, char *argv[]) {
 	// Handle command line arguments
-	if (argc != 3) {
-		std::cerr << "Usage: " << argv[0] << " InputFile OutputFile" << std::endl;
+	bool multiSymbol = false;
+	int numThreads = static_cast<int>(ThreadPool::defaultThreadCount());
+	bool range = false;
+	std::uint64_t offset = 0;
+	std::uint64_t length = UINT64_MAX;
+	std::vector<Dictionary> dictionaries;
+	int argi = 1;
+	for (; argi < argc && std::strncmp(argv[argi], "--", 2) == 0; argi++) {
+		const char *arg = argv[argi];
+		if (std::strcmp(arg, "--decoder=single") == 0)
+			multiSymbol = false;
+		else if (std::strcmp(arg, "--decoder=multi") == 0)
+			multiSymbol = true;
+		else if (std::strncmp(arg, "--dictionary=", 13) == 0 && arg[13] != '\0') {
+			std::filebuf dictFile;
+			std::istream dictIn(CommandLine::openInput(arg + 13, dictFile));
+			dictionaries.push_back(Dictionary::read(dictIn));
+		} else if (CommandLine::parseUint64Option(arg, "--offset=", offset) || CommandLine::parseUint64Option(arg, "--length=", length))
+			range = true;
+		else if (!CommandLine::parseIntOption(arg, "--threads=", 1, 1024, numThreads)) {
+			argi = argc;  // Show usage
+			break;
+		}
+	}
+	if (argc - argi != 2) {
+		std::cerr << "Usage: " << argv[0] << " [--decoder=single|multi] [--dictionary=FILE]... [--threads=N] [--offset=N] [--length=N] InputFile OutputFile" << std::endl;
 		return EXIT_FAILURE;
 	}
-	const char *inputFile  = argv[1];
-	const char *outputFile = argv[2];
+	const char *inputFile  = argv[argi + 0];
+	const char *outputFile = argv[argi + 1];
 	
 	// Perform file decompression
-	std::ifstream in(inputFile, std::ios::binary);
-	std::ofstream out(outputFile, std::ios::binary);
+	std::filebuf inFile;
+	std::filebuf outFile;
+	if (range) {
+		std::istream in(CommandLine::openInput(inputFile, inFile));
+		std::ostream out(CommandLine::openOutput(outputFile, outFile));
+		return decompressRange(in, out, multiSymbol, offset, length);
+	}
+	if (MappedInput::isRegularFile(inputFile)) {
+		const MappedInput in(inputFile);
+		if (in.size() > 0 && in.data()[0] == FramedFormat::MAGIC[0]) {
+			decompressFramed(in.data(), in.size(), outputFile, multiSymbol, static_cast<unsigned int>(numThreads));
+			return EXIT_SUCCESS;
+		}
+		std::ostream out(CommandLine::openOutput(outputFile, outFile));
+		BitInputStream bin(in.data(), in.size());
+		return decompressPlain(bin, out, multiSymbol, dictionaries);
+	}
+	
+	// Stream a pipe or standard input with bounded memory
+	std::istream in(CommandLine::openInput(inputFile, inFile));
+	std::ostream out(CommandLine::openOutput(outputFile, outFile));
+	if (in.peek() == FramedFormat::MAGIC[0]) {
+		FramedDecompressor decomp(multiSymbol, static_cast<unsigned int>(numThreads));
+		decomp.decompress(in, out);
+		return EXIT_SUCCESS;
+	}
 	BitInputStream bin(in);
+	return decompressPlain(bin, out, multiSymbol, dictionaries);
+}
+
+
+// Reads the code length table or dictionary ID of the plain format, then decodes the data. Returns the exit status.
+static int decompressPlain(BitInputStream &bin, std::ostream &out, bool multiSymbol, const std::vector<Dictionary> &dictionaries) {
 	try {
 		
-		// Read code length table
-		std::vector<uint32_t> codeLengths;
-		for (int i = 0; i < 257; i++) {
-			// For this file format, we read 8 bits in big endian
-			uint32_t val = 0;
-			for (int j = 0; j < 8; j++)
-				val = (val << 1) | bin.readNoEof();
-			codeLengths.push_back(val);
-		}
-		const CanonicalCode canonCode(codeLengths);
-		const CodeTree code = canonCode.toCodeTree();
-		
-		HuffmanDecoder dec(bin);
-		dec.codeTree = &code;
-		while (true) {
-			uint32_t symbol = dec.read();
-			if (symbol == 256)  // EOF symbol
-				break;
-			int b = static_cast<int>(symbol);
-			if (std::numeric_limits<char>::is_signed)
-				b -= (b >> 7) << 8;
-			out.put(static_cast<char>(b));
+		uint32_t first = static_cast<uint32_t>(bin.readBits(8));
+		if (first == Dictionary::MARKER) {
+			// Use the prebuilt tables of the dictionary
+			const Dictionary &dict = findDictionary(dictionaries, static_cast<uint32_t>(bin.readBits(32)));
+			if (multiSymbol)
+				decodeMulti(bin, dict.getMultiDecodeTable(), out);
+			else
+				decodeSingle(bin, dict.getDecodeTable(), out);
+			return EXIT_SUCCESS;
 		}
+		const CanonicalCode canonCode = Huffman::readCodeLengthTable(first, bin);
+		if (multiSymbol)
+			decodeMulti(bin, MultiDecodeTable(canonCode, MultiDecodeTable::DEFAULT_TABLE_BITS, 256), out);
+		else
+			decodeSingle(bin, DecodeTable(canonCode, DecodeTable::DEFAULT_TABLE_BITS), out);
 		return EXIT_SUCCESS;
 		
 	} catch (const char *msg) {
@@ -69,3 +151,98 @@ int main(int argc, char *argv[]) {
 		return EXIT_FAILURE;
 	}
 }
+
+
+// Returns the dictionary with the given ID, or throws runtime_error if none was given.
+static const Dictionary &findDictionary(const std::vector<Dictionary> &dictionaries, uint32_t id) {
+	for (const Dictionary &dict : dictionaries) {
+		if (dict.getId() == id)
+			return dict;
+	}
+	throw std::runtime_error("No dictionary with ID " + std::to_string(id));
+}
+
+
+// Decodes symbols one per table lookup until the EOF symbol.
+static void decodeSingle(BitInputStream &bin, const DecodeTable &table, std::ostream &out) {
+	std::vector<char> buffer;
+	buffer.reserve(BUFFER_SIZE);
+	while (true) {
+		uint32_t symbol = table.read(bin);
+		if (symbol == 256)  // EOF symbol
+			break;
+		appendByte(buffer, symbol, out);
+	}
+	out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+
+// Decodes up to several symbols per table lookup until the EOF symbol.
+static void decodeMulti(BitInputStream &bin, const MultiDecodeTable &table, std::ostream &out) {
+	std::vector<char> buffer;
+	buffer.reserve(BUFFER_SIZE);
+	uint32_t symbols[MultiDecodeTable::MAX_SYMBOLS_PER_ENTRY];
+	while (true) {
+		int n = table.read(bin, symbols);
+		// Only the last symbol of an entry can be the EOF symbol, because it is the stop symbol
+		for (int i = 0; i < n - 1; i++)
+			appendByte(buffer, symbols[i], out);
+		if (symbols[n - 1] == 256)  // EOF symbol
+			break;
+		appendByte(buffer, symbols[n - 1], out);
+	}
+	out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+
+// Appends the given byte value to the given buffer, writing out the buffer when it becomes full.
+static void appendByte(std::vector<char> &buffer, uint32_t symbol, std::ostream &out) {
+	int b = static_cast<int>(symbol);
+	if (std::numeric_limits<char>::is_signed)
+		b -= (b >> 7) << 8;
+	buffer.push_back(static_cast<char>(b));
+	if (buffer.size() == BUFFER_SIZE) {
+		out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		buffer.clear();
+	}
+}
+
+
+// Decodes the blocks of the given framed file in parallel, straight into the mapped output file.
+static void decompressFramed(const uint8_t *data, std::size_t length, const char *outputFile, bool multiSymbol, unsigned int numThreads) {
+	const std::vector<BlockLocation> directory = FramedDecompressor::readDirectory(data, length);
+	std::uint64_t size = FramedDecompressor::decompressedSize(directory);
+	if (size > SIZE_MAX)
+		throw std::length_error("Decompressed data too large");
+	MappedOutput out(outputFile, static_cast<std::size_t>(size));
+	FramedDecompressor decomp(multiSymbol, numThreads);
+	decomp.decodeBlocks(data, directory, out.data());
+	out.finish();
+}
+
+
+// Decodes the given range of a framed file (clipped to the end of the data) one block at a time,
+// so that each overlapping block is decoded exactly once. Returns the exit status.
+static int decompressRange(std::istream &in, std::ostream &out, bool multiSymbol, std::uint64_t offset, std::uint64_t length) {
+	FramedReader reader(in, multiSymbol);
+	if (offset > reader.size()) {
+		std::cerr << "Offset past end of data" << std::endl;
+		return EXIT_FAILURE;
+	}
+	length = std::min(reader.size() - offset, length);
+	std::vector<uint8_t> buffer;
+	for (const BlockLocation &loc : reader.getDirectory()) {
+		if (length == 0)
+			break;
+		std::uint64_t end = loc.rawOffset + loc.rawSize;
+		if (end <= offset)
+			continue;
+		std::size_t n = static_cast<std::size_t>(std::min(end - offset, length));
+		buffer.resize(n);
+		reader.decompressRange(offset, n, buffer.data());
+		out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(n));
+		offset += n;
+		length -= n;
+	}
+	return EXIT_SUCCESS;
+}
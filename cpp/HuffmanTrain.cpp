@@ -0,0 +1,73 @@
+/* 
+ * Training application for pre-trained Huffman code dictionaries
+ * 
+ * Usage: HuffmanTrain [--max-code-length=N] [--id=N] DictionaryFile SampleFile...
+ * Counts the byte frequencies of the given sample files, each treated as one message, and writes a
+ * dictionary file with the optimal code for them (see Dictionary.hpp). Give the dictionary file to
+ * the --dictionary option of "HuffmanCompress" and "HuffmanDecompress" to compress small messages
+ * like the samples without the cost of a code length table, and without a frequency counting pass.
+ * The --max-code-length option limits the length of every code (between 9 and 255, default 15).
+ * The --id option sets the dictionary ID (between 0 and 2^32 - 1, default: derived from the code lengths).
+ * 
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "CanonicalCode.hpp"
+#include "CommandLine.hpp"
+#include "Dictionary.hpp"
+#include "FramedFormat.hpp"
+#include "FrequencyTable.hpp"
+#include "MappedFile.hpp"
+
+using std::uint32_t;
+
+
+int main(int argc, char *argv[]) {
+	// Handle command line arguments
+	int maxCodeLength = static_cast<int>(Dictionary::DEFAULT_MAX_CODE_LENGTH);
+	bool hasId = false;
+	uint32_t id = 0;
+	int argi = 1;
+	for (; argi < argc && std::strncmp(argv[argi], "--", 2) == 0; argi++) {
+		const char *arg = argv[argi];
+		if (CommandLine::parseUint32Option(arg, "--id=", 0, id))
+			hasId = true;
+		else if (!CommandLine::parseIntOption(arg, "--max-code-length=", Dictionary::MIN_CODE_LENGTH, FramedFormat::MAX_CODE_LENGTH, maxCodeLength)) {
+			argi = argc;  // Show usage
+			break;
+		}
+	}
+	if (argc - argi < 2) {
+		std::cerr << "Usage: " << argv[0] << " [--max-code-length=N] [--id=N] DictionaryFile SampleFile..." << std::endl;
+		return EXIT_FAILURE;
+	}
+	const char *dictionaryFile = argv[argi];
+	
+	// Count the byte frequencies of all samples, and one EOF symbol per sample
+	FrequencyTable freqs(std::vector<uint32_t>(Dictionary::SYMBOL_LIMIT, 0));
+	for (int i = argi + 1; i < argc; i++) {
+		const MappedInput in(argv[i]);
+		freqs.incrementBytes(in.data(), in.size());
+		freqs.increment(Dictionary::EOF_SYMBOL);
+	}
+	const CanonicalCode code = Dictionary::train(freqs, static_cast<uint32_t>(maxCodeLength));
+	const Dictionary dict(hasId ? id : Dictionary::defaultId(code), code);
+	
+	std::ofstream out(dictionaryFile, std::ios::binary);
+	if (!out) {
+		std::cerr << "Cannot open " << dictionaryFile << std::endl;
+		return EXIT_FAILURE;
+	}
+	dict.write(out);
+	std::cout << "Dictionary ID: " << dict.getId() << std::endl;
+	return EXIT_SUCCESS;
+}
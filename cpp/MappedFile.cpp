@@ -0,0 +1,205 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "MappedFile.hpp"
+
+using std::size_t;
+using std::uint8_t;
+
+
+static std::runtime_error ioError(const char *what, const char *path);
+static void writeFully(int fd, const uint8_t *data, size_t length);
+
+
+/*---- MappedInput ----*/
+
+MappedInput::MappedInput(const char *path) :
+		fd(-1),
+		mapping(nullptr),
+		dataPtr(nullptr),
+		length(0) {
+	// Standard input is never mapped, because it may be positioned anywhere in a file
+	bool standard = std::strcmp(path, "-") == 0;
+	fd = standard ? dup(STDIN_FILENO) : open(path, O_RDONLY);
+	if (fd == -1)
+		throw ioError("Cannot open", path);
+	
+	// Map a non-empty regular file
+	struct stat st;
+	if (!standard && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0
+			&& static_cast<unsigned long long>(st.st_size) <= SIZE_MAX) {
+		length = static_cast<size_t>(st.st_size);
+		mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED) {
+			madvise(mapping, length, MADV_SEQUENTIAL);
+			dataPtr = static_cast<const uint8_t*>(mapping);
+			return;
+		}
+		mapping = nullptr;
+		length = 0;
+	}
+	
+	// Otherwise read everything, doubling the buffer as needed
+	while (true) {
+		if (length == buffer.size())
+			buffer.resize(std::max(buffer.size() * 2, static_cast<size_t>(65536)));
+		ssize_t n = read(fd, &buffer[length], buffer.size() - length);
+		if (n == 0)
+			break;
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			std::runtime_error e = ioError("Cannot read", path);
+			close(fd);
+			throw e;
+		}
+		length += static_cast<size_t>(n);
+	}
+	dataPtr = buffer.data();
+}
+
+
+MappedInput::~MappedInput() {
+	if (mapping != nullptr)
+		munmap(mapping, length);
+	if (fd != -1)
+		close(fd);
+}
+
+
+const uint8_t *MappedInput::data() const {
+	return dataPtr;
+}
+
+
+size_t MappedInput::size() const {
+	return length;
+}
+
+
+bool MappedInput::isRegularFile(const char *path) {
+	struct stat st;
+	return std::strcmp(path, "-") != 0 && stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+
+/*---- MappedOutput ----*/
+
+MappedOutput::MappedOutput(const char *path, size_t size) :
+		fd(-1),
+		mapping(nullptr),
+		dataPtr(nullptr),
+		length(size) {
+	// Standard output is never mapped, because it may be positioned anywhere in a file
+	bool standard = std::strcmp(path, "-") == 0;
+	if (standard)
+		fd = dup(STDOUT_FILENO);
+	else {
+		fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+		if (fd == -1)
+			fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);  // For example a pipe
+	}
+	if (fd == -1)
+		throw ioError("Cannot open", path);
+	
+	// Map a regular file after reserving its disk space at the final size. Without the reservation, a full disk
+	// would make a store into the mapping raise SIGBUS, whereas the buffer's write() reports an ordinary error
+	struct stat st;
+	if (!standard && size > 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		if (posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0) {
+			mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (mapping != MAP_FAILED) {
+				dataPtr = static_cast<uint8_t*>(mapping);
+				return;
+			}
+			mapping = nullptr;
+		}
+		if (ftruncate(fd, 0) != 0) {  // Drop any partial reservation before writing from the start
+			std::runtime_error e = ioError("Cannot truncate", path);
+			close(fd);
+			throw e;
+		}
+	}
+	// The destructor does not run if the constructor throws, so close the file here
+	try {
+		buffer.resize(size);
+	} catch (...) {
+		close(fd);
+		throw;
+	}
+	dataPtr = buffer.data();
+}
+
+
+MappedOutput::~MappedOutput() {
+	if (mapping != nullptr)
+		munmap(mapping, length);
+	if (fd != -1)
+		close(fd);
+}
+
+
+uint8_t *MappedOutput::data() {
+	return dataPtr;
+}
+
+
+size_t MappedOutput::size() const {
+	return length;
+}
+
+
+void MappedOutput::finish() {
+	if (fd == -1)
+		throw std::logic_error("Already finished");
+	if (mapping != nullptr) {
+		if (munmap(mapping, length) != 0)
+			throw std::runtime_error("Cannot unmap output file");
+		mapping = nullptr;
+	} else {
+		writeFully(fd, buffer.data(), buffer.size());
+		std::vector<uint8_t>().swap(buffer);
+	}
+	dataPtr = nullptr;
+	int result = close(fd);
+	fd = -1;
+	if (result != 0)
+		throw std::runtime_error("Cannot close output file");
+}
+
+
+/*---- Helper functions ----*/
+
+// Returns an exception describing the given failed operation on the given path and the current errno.
+static std::runtime_error ioError(const char *what, const char *path) {
+	return std::runtime_error(std::string(what) + " " + path + ": " + std::strerror(errno));
+}
+
+
+// Writes all the given bytes to the given file descriptor, retrying after partial writes.
+static void writeFully(int fd, const uint8_t *data, size_t length) {
+	while (length > 0) {
+		ssize_t n = write(fd, data, length);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			throw ioError("Cannot write", "output file");
+		}
+		data += n;
+		length -= static_cast<size_t>(n);
+	}
+}
@@ -0,0 +1,126 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/* 
+ * The whole contents of an input file as one read-only array of bytes. A regular file is memory-mapped,
+ * so its bytes are paged in on demand without being copied. Anything else that can be opened by path
+ * (such as a pipe or a terminal), and standard input given as the path "-", is read to its end into a
+ * buffer instead. Requires a POSIX system.
+ */
+class MappedInput final {
+	
+	/*---- Fields ----*/
+	
+	// The file descriptor, or -1 if closed.
+	private: int fd;
+	
+	// The start of the mapping, or null if the contents are in the buffer instead.
+	private: void *mapping;
+	
+	// The contents of a file that could not be mapped.
+	private: std::vector<std::uint8_t> buffer;
+	
+	// The start and length of the contents.
+	private: const std::uint8_t *dataPtr;
+	private: std::size_t length;
+	
+	
+	/*---- Constructor and destructor ----*/
+	
+	// Opens the file at the given path and maps or reads its contents. Throws an exception on I/O error.
+	public: explicit MappedInput(const char *path);
+	
+	
+	public: ~MappedInput();
+	
+	
+	/*---- Methods ----*/
+	
+	// Returns a pointer to the contents, which stays valid for the life of this object.
+	public: const std::uint8_t *data() const;
+	
+	
+	// Returns the number of bytes in the contents.
+	public: std::size_t size() const;
+	
+	
+	// Tests whether the given path names a regular file (not "-"), whose contents would be mapped rather than read.
+	public: static bool isRegularFile(const char *path);
+	
+	
+	// Copying would duplicate ownership of the mapping.
+	public: MappedInput(const MappedInput &) = delete;
+	public: MappedInput &operator=(const MappedInput &) = delete;
+	
+};
+
+
+
+/* 
+ * An output file of a size known in advance, written as one array of bytes. A regular file is created
+ * at that size with its disk space reserved, and memory-mapped, so data stored in the array goes straight
+ * to the file without a copy. If the path cannot be mapped (such as a pipe, or standard output given as
+ * the path "-"), or the space cannot be reserved (such as on a full disk, where stores into a mapping would
+ * crash with SIGBUS), the array is a buffer that is written out by finish(), which reports any error.
+ * Requires a POSIX system.
+ */
+class MappedOutput final {
+	
+	/*---- Fields ----*/
+	
+	// The file descriptor, or -1 if closed.
+	private: int fd;
+	
+	// The start of the mapping, or null if the buffer is used instead.
+	private: void *mapping;
+	
+	// The data to write to a file that could not be mapped.
+	private: std::vector<std::uint8_t> buffer;
+	
+	// The start and length of the array.
+	private: std::uint8_t *dataPtr;
+	private: std::size_t length;
+	
+	
+	/*---- Constructor and destructor ----*/
+	
+	// Creates or truncates the file at the given path, and provides an array of the given size for
+	// its contents. The array's initial values are unspecified. Throws an exception on I/O error.
+	public: explicit MappedOutput(const char *path, std::size_t size);
+	
+	
+	// Releases the file. Data not yet committed by finish() may or may not reach the file.
+	public: ~MappedOutput();
+	
+	
+	/*---- Methods ----*/
+	
+	// Returns a pointer to the array, which stays valid until finish() is called.
+	public: std::uint8_t *data();
+	
+	
+	// Returns the number of bytes in the array.
+	public: std::size_t size() const;
+	
+	
+	// Writes the array to the file if needed, and closes the file. Throws an exception on I/O error.
+	public: void finish();
+	
+	
+	// Copying would duplicate ownership of the mapping.
+	public: MappedOutput(const MappedOutput &) = delete;
+	public: MappedOutput &operator=(const MappedOutput &) = delete;
+	
+};
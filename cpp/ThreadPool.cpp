@@ -0,0 +1,72 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include "ThreadPool.hpp"
+
+
+ThreadPool::ThreadPool(unsigned int numThreads) :
+		stopping(false) {
+	if (numThreads < 1)
+		throw std::domain_error("At least 1 thread needed");
+	for (unsigned int i = 0; i < numThreads; i++)
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for (std::thread &worker : workers)
+		worker.join();
+}
+
+
+std::future<void> ThreadPool::submit(std::function<void()> task) {
+	// The packaged task is shared because std::function requires a copyable callable
+	std::shared_ptr<std::packaged_task<void()> > packaged(new std::packaged_task<void()>(std::move(task)));
+	std::future<void> result = packaged->get_future();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push([packaged]() { (*packaged)(); });
+	}
+	condition.notify_one();
+	return result;
+}
+
+
+unsigned int ThreadPool::size() const {
+	return static_cast<unsigned int>(workers.size());
+}
+
+
+unsigned int ThreadPool::defaultThreadCount() {
+	unsigned int result = std::thread::hardware_concurrency();
+	return result > 0 ? result : 1;
+}
+
+
+void ThreadPool::workerLoop() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (tasks.empty())
+				return;  // Stopping, and all queued tasks have been taken
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+		task();  // Exceptions are captured by the packaged task
+	}
+}
@@ -0,0 +1,77 @@
+/* 
+ * Reference Huffman coding
+ * Copyright (c) Project Nayuki
+ * 
+ * https://www.nayuki.io/page/reference-huffman-coding
+ * https://github.com/nayuki/Reference-Huffman-coding
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+
+/* 
+ * A fixed set of worker threads that run submitted tasks in submission order.
+ * Each task's result (or exception) is delivered through the future returned by submit().
+ * The destructor waits for all submitted tasks to finish, then stops the workers.
+ */
+class ThreadPool final {
+	
+	/*---- Fields ----*/
+	
+	// The worker threads, which live as long as this object.
+	private: std::vector<std::thread> workers;
+	
+	// Tasks that have been submitted but not yet started.
+	private: std::queue<std::function<void()> > tasks;
+	
+	// Guards the tasks queue and the stopping flag.
+	private: std::mutex mutex;
+	
+	// Signaled when a task is queued or when the pool is stopping.
+	private: std::condition_variable condition;
+	
+	// Set by the destructor to tell idle workers to exit.
+	private: bool stopping;
+	
+	
+	/*---- Constructor and destructor ----*/
+	
+	// Constructs a thread pool with the given number of worker threads, which must be at least 1.
+	public: explicit ThreadPool(unsigned int numThreads);
+	
+	
+	public: ~ThreadPool();
+	
+	
+	/*---- Methods ----*/
+	
+	// Queues the given task to be run by a worker thread, and returns a future that becomes ready
+	// when the task finishes. If the task throws an exception, then the future's get() rethrows it.
+	public: std::future<void> submit(std::function<void()> task);
+	
+	
+	// Returns the number of worker threads.
+	public: unsigned int size() const;
+	
+	
+	// Returns the number of hardware threads, or 1 if that number is not known.
+	public: static unsigned int defaultThreadCount();
+	
+	
+	// The loop run by each worker thread.
+	private: void workerLoop();
+	
+	
+	// Copying would duplicate ownership of the threads.
+	public: ThreadPool(const ThreadPool &) = delete;
+	public: ThreadPool &operator=(const ThreadPool &) = delete;
+	
+};